@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/* Commands of the zmk,behavior-pmw3610 behavior, the first binding parameter. The second one is
+ * the cpi (or cpi step) of the cpi commands, and unused by the others. */
+#define PMW_CPI_SET 0            // set the cpi of every mode but SNIPE
+#define PMW_CPI_UP 1             // raise the cpi by a step, up to the max
+#define PMW_CPI_DOWN 2           // lower the cpi by a step, down to the min
+#define PMW_CPI_CYCLE 3          // raise the cpi by a step, back to the min past the max
+#define PMW_SNIPE_CPI_SET 4      // set the cpi of the SNIPE mode
+#define PMW_FORCE_AWAKE_ON 5     // keep the sensor in the RUN state
+#define PMW_FORCE_AWAKE_OFF 6    // let the sensor downshift to the rest states
+#define PMW_FORCE_AWAKE_TOGGLE 7
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 The ZMK Contributors
+#
+# SPDX-License-Identifier: MIT
+
+"""Generate the fixed-point scroll acceleration table of the PMW3610 driver.
+
+The table samples the acceleration curve
+
+    accel(speed) = 1 + (sensitivity - 1) / (1 + exp(-0.2 * (speed - 10)))
+
+with speed in counts/ms, and is linearly interpolated at runtime. The driver computes the speed
+from the interval (in us) between the frame timestamps of two scroll frames. Before writing the
+table, the integer runtime computation is checked against the float curve over sub-ms and ms
+intervals, and generation fails if any output differs by more than one count.
+"""
+
+import argparse
+import math
+import sys
+
+# multiplier precision, in bits
+ACCEL_SHIFT = 12
+# speed is computed in Q12 counts/ms and the table has a step of 2^(STEP_SHIFT - 12) counts/ms
+SPEED_SHIFT = 12
+STEP_SHIFT = 10
+# speed covered by the table, the curve is flat beyond it
+MAX_SPEED = 64
+# the driver only accelerates when the previous scroll frame is less than 100 ms old
+MAX_DELTA_US = 100 * 1000 - 1
+# intervals checked by verify(): sub-ms ones, and whole and half ms ones
+VERIFY_DELTAS_US = sorted({d for d in range(1, 1000, 7)} |
+                          {ms * 1000 + off for ms in range(1, 100) for off in (0, 500)} |
+                          {MAX_DELTA_US})
+
+
+def accel(sensitivity, speed):
+    return 1.0 + (sensitivity - 1.0) * (1.0 / (1.0 + math.exp(-0.2 * (speed - 10.0))))
+
+
+def build_lut(sensitivity):
+    step = (1 << STEP_SHIFT) / (1 << SPEED_SHIFT)
+    count = int(MAX_SPEED / step) + 1
+    return [round(accel(sensitivity, i * step) * (1 << ACCEL_SHIFT)) for i in range(count)]
+
+
+def trunc_div(num, den):
+    """C integer division, truncating toward zero"""
+    q = abs(num) // den
+    return q if num >= 0 else -q
+
+
+def fixed_accel(lut, value, movement, delta_us):
+    """Integer computation done by the driver, see src/pmw3610_scroll_accel.h"""
+    if abs(value) <= 1:
+        return value
+    speed = min((movement << SPEED_SHIFT) * 1000 // delta_us, (1 << 32) - 1)
+    idx = speed >> STEP_SHIFT
+    if idx >= len(lut) - 1:
+        mult = lut[-1]
+    else:
+        frac = speed & ((1 << STEP_SHIFT) - 1)
+        mult = lut[idx] + (((lut[idx + 1] - lut[idx]) * frac) >> STEP_SHIFT)
+    return trunc_div(value * mult, 1 << ACCEL_SHIFT)
+
+
+def float_accel(sensitivity, value, movement, delta_us):
+    """Float computation the table replaces"""
+    if abs(value) <= 1:
+        return value
+    return int(value * accel(sensitivity, movement * 1000 / delta_us))
+
+
+def verify(sensitivity, lut):
+    worst = 0
+    for delta_us in VERIFY_DELTAS_US:
+        for movement in range(0, 512):
+            # the error grows with the value, so small values and the largest ones are enough
+            for value in {v for v in (2, 3, 5, 8, 13) if v <= movement} | {movement // 2, movement}:
+                for signed in (value, -value):
+                    err = abs(fixed_accel(lut, signed, movement, delta_us) -
+                              float_accel(sensitivity, signed, movement, delta_us))
+                    if err > 1:
+                        sys.exit(f"scroll accel table off by {err} counts (value {signed}, "
+                                 f"movement {movement}, {delta_us} us)")
+                    worst = max(worst, err)
+    return worst
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--sensitivity", type=int, required=True)
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    lut = build_lut(args.sensitivity)
+    worst = verify(args.sensitivity, lut)
+    print(f"scroll accel table: {len(lut)} entries, max error {worst} count(s)")
+
+    rows = [", ".join(str(v) for v in lut[i:i + 12]) for i in range(0, len(lut), 12)]
+    with open(args.output, "w") as out:
+        out.write("/* Generated by scripts/gen_scroll_accel_lut.py, do not edit */\n\n")
+        out.write("#pragma once\n\n")
+        out.write(f"/* scroll acceleration multipliers for sensitivity {args.sensitivity} */\n")
+        out.write(f"#define PMW3610_SCROLL_ACCEL_SHIFT {ACCEL_SHIFT}\n")
+        out.write(f"#define PMW3610_SCROLL_ACCEL_SPEED_SHIFT {SPEED_SHIFT}\n")
+        out.write(f"#define PMW3610_SCROLL_ACCEL_STEP_SHIFT {STEP_SHIFT}\n\n")
+        out.write(f"static const uint16_t pmw3610_scroll_accel_lut[{len(lut)}] = {{\n")
+        for row in rows:
+            out.write(f"    {row},\n")
+        out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Behavior tuning a PMW3610 sensor at runtime through its sensor attributes, see
+ * dt-bindings/pmw3610.h for the commands.
+ */
+
+#define DT_DRV_COMPAT zmk_behavior_pmw3610
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <drivers/behavior.h>
+#include <zmk/behavior.h>
+#include <dt-bindings/pmw3610.h>
+#include "pmw3610.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(pmw3610, CONFIG_INPUT_LOG_LEVEL);
+
+struct behavior_pmw3610_config {
+    const struct device *sensor;
+};
+
+/* New cpi of a cpi command, clamped to the range of the sensor or wrapped around for a cycle */
+static int32_t behavior_pmw3610_next_cpi(uint32_t command, int32_t cpi, int32_t param) {
+    switch (command) {
+    case PMW_CPI_UP:
+        return MIN(cpi + param, PMW3610_MAX_CPI);
+    case PMW_CPI_DOWN:
+        return MAX(cpi - param, PMW3610_MIN_CPI);
+    case PMW_CPI_CYCLE:
+        return cpi + param > PMW3610_MAX_CPI ? PMW3610_MIN_CPI : cpi + param;
+    default:
+        return param;
+    }
+}
+
+static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
+                                     struct zmk_behavior_binding_event event) {
+    const struct device *dev = zmk_behavior_get_binding(binding->behavior_dev);
+    const struct behavior_pmw3610_config *config = dev->config;
+    enum sensor_attribute attr;
+    struct sensor_value val;
+    int err;
+
+    if (!device_is_ready(config->sensor)) {
+        LOG_ERR("Sensor %s not ready", config->sensor->name);
+        return -ENODEV;
+    }
+
+    switch (binding->param1) {
+    case PMW_CPI_SET:
+    case PMW_CPI_UP:
+    case PMW_CPI_DOWN:
+    case PMW_CPI_CYCLE:
+        attr = (enum sensor_attribute)PMW3610_ATTR_CPI;
+        break;
+    case PMW_SNIPE_CPI_SET:
+        attr = (enum sensor_attribute)PMW3610_ATTR_SNIPE_CPI;
+        break;
+    case PMW_FORCE_AWAKE_ON:
+    case PMW_FORCE_AWAKE_OFF:
+    case PMW_FORCE_AWAKE_TOGGLE:
+        attr = (enum sensor_attribute)PMW3610_ATTR_FORCE_AWAKE;
+        break;
+    default:
+        LOG_ERR("Unknown pmw3610 command %u", binding->param1);
+        return -ENOTSUP;
+    }
+
+    err = sensor_attr_get(config->sensor, SENSOR_CHAN_ALL, attr, &val);
+    if (err) {
+        LOG_ERR("Cannot read the sensor attribute: %d", err);
+        return err;
+    }
+
+    switch (binding->param1) {
+    case PMW_FORCE_AWAKE_ON:
+        val.val1 = 1;
+        break;
+    case PMW_FORCE_AWAKE_OFF:
+        val.val1 = 0;
+        break;
+    case PMW_FORCE_AWAKE_TOGGLE:
+        val.val1 = !val.val1;
+        break;
+    default:
+        val.val1 = behavior_pmw3610_next_cpi(binding->param1, val.val1, binding->param2);
+        break;
+    }
+
+    err = sensor_attr_set(config->sensor, SENSOR_CHAN_ALL, attr, &val);
+    if (err) {
+        LOG_ERR("Cannot apply the pmw3610 command %u: %d", binding->param1, err);
+        return err;
+    }
+
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static int on_keymap_binding_released(struct zmk_behavior_binding *binding,
+                                      struct zmk_behavior_binding_event event) {
+    return ZMK_BEHAVIOR_OPAQUE;
+}
+
+static const struct behavior_driver_api behavior_pmw3610_driver_api = {
+    .binding_pressed = on_keymap_binding_pressed,
+    .binding_released = on_keymap_binding_released,
+    // run where the sensor is, e.g. on a split peripheral
+    .locality = BEHAVIOR_LOCALITY_GLOBAL,
+};
+
+#define BEHAVIOR_PMW3610_DEFINE(n)                                                                 \
+    static const struct behavior_pmw3610_config behavior_pmw3610_config_##n = {                    \
+        .sensor = DEVICE_DT_GET(DT_INST_PHANDLE(n, sensor)),                                       \
+    };                                                                                             \
+                                                                                                   \
+    BEHAVIOR_DT_INST_DEFINE(n, NULL, NULL, NULL, &behavior_pmw3610_config_##n, POST_KERNEL,        \
+                            CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &behavior_pmw3610_driver_api);
+
+DT_INST_FOREACH_STATUS_OKAY(BEHAVIOR_PMW3610_DEFINE)
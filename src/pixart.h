@@ -10,6 +10,7 @@
 #include <zephyr/drivers/spi.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/sensor.h>
+#include <zmk/keymap.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,54 +18,244 @@ extern "C" {
 
 enum pixart_input_mode { MOVE = 0, SCROLL, SNIPE, BALL_ACTION };
 
+// input mode of a layer, and the ball action bound to it
+struct pixart_layer_mode {
+    uint8_t mode;       // enum pixart_input_mode
+    int8_t ball_action; // index in pixart_config.ball_actions, -1 if none
+};
+
+// multiplier of 1.0 in an acceleration curve, curves are expressed in permille
+#define PIXART_ACCEL_ONE 1000
+
+// piecewise-linear acceleration curve, points are (speed in counts/frame, multiplier in permille)
+// pairs with ascending speeds. The multiplier is flat before the first and past the last point.
+struct pixart_accel_curve {
+    const int32_t *points;
+    size_t len; // point count, i.e. half the array length
+};
+
+// configuration registers shadowed by the driver
+#define PIXART_SHADOW_SIZE 9
+
+enum pixart_shadow_state {
+    SHADOW_UNSET = 0, // never written by the driver
+    SHADOW_PENDING,   // written or to be written, not known to be held by the sensor
+    SHADOW_SYNCED,    // held by the sensor, as far as the driver knows
+};
+
+struct pixart_reg_shadow {
+    uint8_t reg; // page 1 registers have PMW3610_PAGE1_BIT set
+    uint8_t val;
+    uint8_t state; // enum pixart_shadow_state
+};
+
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+// size of the buffer an asynchronous motion burst is read into
+#define PIXART_BURST_BUF_SIZE 10
+
+// phases of an asynchronous motion burst read
+enum pixart_burst_state {
+    BURST_IDLE = 0,
+    BURST_ADDR_PENDING,
+    BURST_ADDR_DONE,
+    BURST_DATA_PENDING,
+    BURST_DATA_DONE,
+};
+#endif
+
+#ifdef CONFIG_PMW3610_STATS
+// driver statistics, plain counters cheap enough to keep enabled
+struct pixart_stats {
+    uint32_t motion_irqs;         // motion interrupts received
+    uint32_t max_queue_delay_us;  // max delay between the interrupt and the motion work
+    uint32_t drained_bursts;      // bursts read without re-arming the motion interrupt
+    uint32_t reports;             // motion bursts processed
+    uint64_t report_cycles;       // cycles spent processing motion bursts
+    uint64_t busy_wait_us;        // time spent busy-waiting on spi timings
+    uint32_t input_reports;       // input events reported
+    uint32_t report_backpressure; // input events rejected by a full input queue
+    uint32_t reg_restores;        // configuration registers found changed and rewritten
+    uint32_t bursts;              // motion bursts read
+    uint32_t zero_delta_frames;   // motion frames processed without any delta
+    uint32_t spi_err_reg_read;    // spi errors reading a register
+    uint32_t spi_err_reg_write;   // spi errors writing a register
+    uint32_t spi_err_burst_read;  // spi errors reading a motion burst
+    uint32_t cpi_switches;        // cpi changes written to the sensor
+    uint32_t smart_toggles;       // smart algorithm switches
+    uint32_t scroll_ticks;        // scroll wheel ticks reported
+    uint32_t scroll_ticks_truncated; // ticks past the per-frame max, carried to the next frame
+    uint32_t ball_actions;        // ball action bindings queued
+};
+#endif
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+// log2-scaled latency histograms, bucket n > 0 counts the intervals of [2^(n-1), 2^n) us, bucket 0
+// the ones under 1 us and the last bucket every longer interval
+#define PIXART_LATENCY_BUCKETS 16
+
+// stages of the motion path, each timed by a histogram
+enum pixart_latency_stage {
+    LATENCY_IRQ_TO_WORK,      // motion interrupt to the start of the motion work
+    LATENCY_WORK_TO_BURST,    // start of the motion work (or poll) to the burst read completion
+    LATENCY_BURST_TO_REPORT,  // burst read completion to the last input event of its motion
+    LATENCY_STAGE_COUNT,
+};
+
+struct pixart_latency {
+    uint32_t hist[LATENCY_STAGE_COUNT][PIXART_LATENCY_BUCKETS];
+    uint64_t work_cyc;   // start of the motion work, or of the next burst read when draining
+    uint64_t burst_cyc;  // completion of the last burst read
+    bool report_pending; // the motion of the last burst is not fully reported yet
+};
+#endif
+
 /* device data structure */
 struct pixart_data {
     const struct device *dev;
 
     enum pixart_input_mode curr_mode;
+
+    // input mode of every layer, built at init, and the entry of the highest active layer,
+    // updated on layer state changes
+    struct pixart_layer_mode layer_modes[ZMK_KEYMAP_LAYERS_LEN];
+    const struct pixart_layer_mode *active_layer_mode;
+
     uint32_t curr_cpi;
+
+    // runtime settings, initialized from Kconfig and changed through the sensor attributes
+    uint32_t cpi;       // cpi of every mode but SNIPE
+    uint32_t snipe_cpi; // cpi of the SNIPE mode
+    bool force_awake;   // whether the sensor is kept in the RUN state
+    // downshift and rest sample times (in ms), the REST2/REST3 ones being left at the sensor
+    // default when 0
+    uint32_t run_downshift_ms;
+    uint32_t rest1_downshift_ms;
+    uint32_t rest2_downshift_ms;
+    uint32_t rest1_sample_ms;
+    uint32_t rest2_sample_ms;
+    uint32_t rest3_sample_ms;
+
     int32_t scroll_delta_x;
     int32_t scroll_delta_y;
     int32_t ball_action_delta_x;
     int32_t ball_action_delta_y;
 
-#ifdef CONFIG_PMW3610_POLLING_RATE_125_SW
-    int64_t last_poll_time;
-    int16_t last_x;
-    int16_t last_y;
-#endif
+    // sub-count remainder of the cpi dividor or software cpi scaling, in counts scaled by the
+    // divisor of the current mode
+    int32_t scale_rem_x;
+    int32_t scale_rem_y;
+
+    // sub-count remainder of the acceleration curve, in counts scaled by PIXART_ACCEL_ONE
+    int32_t accel_rem_x;
+    int32_t accel_rem_y;
+
+    // pointer motion not reported yet, and the time of the last pointer report
+    int32_t report_x;
+    int32_t report_y;
+    bool report_y_unsynced;    // x of the last report went through, but its y and sync did not
+    uint64_t report_frame_cyc; // timestamp of the newest frame in report_x/y
+    uint64_t last_report_cyc;  // timestamp of the newest frame in the last report
+    bool last_report_valid;    // whether a report was made yet
+    struct k_work_delayable flush_work;
 
 #ifdef CONFIG_PMW3610_SCROLL_ACCELERATION
-    int64_t last_scroll_time;
+    uint64_t last_scroll_cyc; // timestamp of the last scroll frame
+    bool last_scroll_valid;   // whether a scroll frame was processed yet
 #endif
 
 #ifdef CONFIG_PMW3610_SCROLL_SNAP
     int32_t scroll_snap_accumulated_x;
     int32_t scroll_snap_accumulated_y;
-    int64_t scroll_snap_last_time;
-    int64_t scroll_snap_deadtime_start;  // デッドタイム開始時刻
+    uint64_t scroll_snap_last_cyc;
+    bool scroll_snap_last_valid;         // scroll_snap_last_cyc is set until the axis lock resets
+    uint64_t scroll_snap_deadtime_cyc;   // デッドタイム開始時刻
     bool scroll_snap_in_deadtime;        // デッドタイム中かどうか
 #endif
 
     // motion interrupt isr
     struct gpio_callback irq_gpio_cb;
+
+    // motion polling, without a motion interrupt line
+    struct k_work_delayable poll_work;
+    uint32_t poll_interval_ms;
+    int64_t poll_last_motion;
     // the work structure holding the trigger job
     struct k_work trigger_work;
 
+    // the work structure applying the runtime settings and the cpi of a new input mode
+    struct k_work_delayable config_work;
+    uint32_t config_retry_ms;  // backoff after failed attempts, 0 once the settings are written
+    atomic_t settings_changed; // set by the attributes, the config work then writes the settings
+
+    // deactivates the automouse layer once the pointer stops moving
+    struct k_timer automouse_layer_timer;
+    bool automouse_triggered;
+
+    // timestamp (cycle count) of the frame being read: the motion interrupt, the poll, or the read
+    // of a drained burst. Every time based processing of the frame uses it. 64-bit, so that the
+    // intervals between frames never wrap around.
+    uint64_t frame_cyc;
+
+#ifdef CONFIG_PMW3610_STATS
+    struct pixart_stats stats;
+#endif
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    struct pixart_latency latency;
+#endif
+
+    // serializes transaction sequences on the sensor
+    struct k_sem bus_sem;
+
+#ifdef CONFIG_PMW3610_MOTION_DRAIN
+    // bursts read since the motion interrupt was last armed
+    uint32_t drain_count;
+#endif
+
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+    // state and buffers of the in-flight motion burst, they must outlive the transfer
+    enum pixart_burst_state burst_state;
+    int burst_err;
+    uint8_t burst_addr;
+    uint8_t burst_buf[PIXART_BURST_BUF_SIZE];
+    struct spi_buf burst_spi_buf;
+    struct spi_buf_set burst_spi_set;
+#endif
+
     // the work structure for delayable init steps
     struct k_work_delayable init_work;
     int async_init_step;
+    int64_t init_step_start; // end of the previous init step, to time and bound the next one
 
     //
     bool ready;           // whether init is finished successfully
+    bool suspended;       // whether power management requests the sensor to be shut down
     bool last_read_burst; // todo: needed?
     int err;              // error code during async init
 
+#ifdef CONFIG_PMW3610_SUSPEND_ON_IDLE
+    // runtime PM reference changes requested by the activity listener
+    struct k_work_delayable idle_work;
+    bool idle_requested; // the keyboard is idle, so the reference is to be released
+    bool idle_released;  // the runtime PM reference of the driver is released while idle
+#endif
+
     // for pmw3610 smart algorithm
     bool sw_smart_flag;
 
-    // for scroll acceleration
-    int64_t last_remainder_time;
+    // configuration registers, and their periodic readback
+    struct pixart_reg_shadow shadow[PIXART_SHADOW_SIZE];
+#if CONFIG_PMW3610_REG_CHECK_INTERVAL_MS > 0
+    struct k_work_delayable reg_check_work;
+#endif
+
+    // end of the last spi transaction (in cycles) and the gap (in us) the sensor requires
+    // before the next one may start
+    uint32_t last_xfer_cyc;
+    uint32_t xfer_gap_us;
+
+    // timestamp of the frame which left scroll ticks past the per-frame max, if valid
+    uint64_t last_remainder_cyc;
+    bool last_remainder_valid;
 
 };
 
@@ -90,6 +281,9 @@ struct pixart_config {
     int32_t *snipe_layers;
     struct ball_action_cfg **ball_actions;
     size_t ball_actions_len;
+    int32_t automouse_layer; // layer activated on pointer motion, -1 if none
+    struct pixart_accel_curve accel_curve;       // MOVE, empty to use the default
+    struct pixart_accel_curve snipe_accel_curve; // SNIPE, empty to use the MOVE one
 };
 
 #ifdef __cplusplus
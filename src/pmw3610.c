@@ -16,7 +16,6 @@
 #include <zephyr/device.h>
 #include <zephyr/sys/dlist.h>
 #include <drivers/behavior.h>
-#include <math.h>
 #include <zmk/keymap.h>
 #include <zmk/behavior.h>
 #include <zmk/keys.h>
@@ -24,8 +23,15 @@
 #include <zmk/event_manager.h>
 #include <zmk/events/position_state_changed.h>
 #include <zmk/events/layer_state_changed.h>
+#include <zmk/events/activity_state_changed.h>
+#include <zephyr/pm/device.h>
+#include <zephyr/pm/device_runtime.h>
 #include "pmw3610.h"
 
+#ifdef CONFIG_PMW3610_SCROLL_ACCELERATION
+#include "pmw3610_scroll_accel.h"
+#endif
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(pmw3610, CONFIG_INPUT_LOG_LEVEL);
 
@@ -43,18 +49,16 @@ enum pmw3610_init_step {
     ASYNC_INIT_STEP_COUNT // end flag
 };
 
-/* Timings (in ms) needed in between steps to allow each step finishes succussfully. */
+/* Timings (in ms) waited before each step. */
 // - Since MCU is not involved in the sensor init process, i is allowed to do other tasks.
 //   Thus, k_sleep or delayed schedule can be used.
+// - A step which finds the sensor not ready yet returns -EAGAIN and is retried every
+//   CONFIG_PMW3610_INIT_POLL_INTERVAL_MS, up to CONFIG_PMW3610_INIT_TIMEOUT_MS after the previous
+//   step. The delays are thus only the minimums, the rest is waited for by polling the sensor.
 static const int32_t async_init_delay[ASYNC_INIT_STEP_COUNT] = {
     [ASYNC_INIT_STEP_POWER_UP] = 10, // test shows > 5ms needed
-    [ASYNC_INIT_STEP_CLEAR_OB1] =
-        200,                          // 150 us required, test shows too short,
-                                      // also power-up reset is added in this step, thus using 50 ms
-    [ASYNC_INIT_STEP_CHECK_OB1] = 50, // 10 ms required in spec,
-                                      // test shows too short,
-                                      // especially when integrated with display,
-                                      // > 50ms is needed
+    [ASYNC_INIT_STEP_CLEAR_OB1] = 1, // polls the product id, until the power-up reset is done
+    [ASYNC_INIT_STEP_CHECK_OB1] = 10, // 10 ms required in spec, then polls the self-test bits
     [ASYNC_INIT_STEP_CONFIGURE] = 0,
 };
 
@@ -70,15 +74,145 @@ static int (*const async_init_fn[ASYNC_INIT_STEP_COUNT])(const struct device *de
     [ASYNC_INIT_STEP_CONFIGURE] = pmw3610_async_init_configure,
 };
 
+#ifdef CONFIG_PMW3610_DEDICATED_WORKQUEUE
+// motion processing runs on its own work queue, shared by all sensor instances, so that the
+// latency does not depend on whatever else is queued on the system work queue
+K_THREAD_STACK_DEFINE(pmw3610_work_q_stack, CONFIG_PMW3610_WORKQUEUE_STACK_SIZE);
+static struct k_work_q pmw3610_work_q;
+
+static void pmw3610_work_q_start(void) {
+    static bool started;
+
+    if (started) {
+        return;
+    }
+
+    const struct k_work_queue_config cfg = {.name = "pmw3610_work_q"};
+    k_work_queue_start(&pmw3610_work_q, pmw3610_work_q_stack,
+                       K_THREAD_STACK_SIZEOF(pmw3610_work_q_stack),
+                       CONFIG_PMW3610_WORKQUEUE_PRIORITY, &cfg);
+    started = true;
+}
+#endif
+
+// submit a work item to the queue running the motion path
+static inline int pmw3610_submit_work(struct k_work *work) {
+#ifdef CONFIG_PMW3610_DEDICATED_WORKQUEUE
+    return k_work_submit_to_queue(&pmw3610_work_q, work);
+#else
+    return k_work_submit(work);
+#endif
+}
+
+// schedule a delayable work item on the queue running the motion path
+static inline int pmw3610_schedule_work(struct k_work_delayable *dwork, k_timeout_t delay) {
+#ifdef CONFIG_PMW3610_DEDICATED_WORKQUEUE
+    return k_work_schedule_for_queue(&pmw3610_work_q, dwork, delay);
+#else
+    return k_work_schedule(dwork, delay);
+#endif
+}
+
+// without a motion irq line, the motion register is polled
+static inline bool pmw3610_polling(const struct device *dev) {
+    const struct pixart_config *config = dev->config;
+    return config->irq_gpio.port == NULL;
+}
+
+/* Frame timestamp (see pixart_data.frame_cyc) */
+static inline uint64_t frame_timestamp(void) {
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return k_cycle_get_64();
+#else
+    return k_ticks_to_cyc_floor64(k_uptime_ticks());
+#endif
+}
+
+/* Time (in us) between two frame timestamps, saturated at UINT32_MAX. The cycle count is bounded
+ * before its conversion, which would overflow on intervals of days. */
+static inline uint32_t frame_interval_us(uint64_t from_cyc, uint64_t to_cyc) {
+    uint64_t cyc = to_cyc - from_cyc;
+
+    if (cyc >= k_us_to_cyc_floor64(UINT32_MAX)) {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t)k_cyc_to_us_floor64(cyc);
+}
+
 //////// Function definitions //////////
 
+/* All SPI timing waits go through here so that the time spent spinning is accounted */
+static void spi_busy_wait(const struct device *dev, uint32_t us) {
+    struct pixart_data *data = dev->data;
+
+    k_busy_wait(us);
+    PMW3610_STATS_ADD(data, busy_wait_us, us);
+}
+
+/* Record the end of a transaction and the gap the sensor needs before the next one. The wait
+ * itself is deferred to the next transaction, which usually starts long after the gap passed. */
+static void spi_end_xfer(const struct device *dev, uint32_t gap_us) {
+    struct pixart_data *data = dev->data;
+
+    data->last_xfer_cyc = k_cycle_get_32();
+    data->xfer_gap_us = gap_us;
+}
+
+/* Busy wait only for what is left of the gap recorded by spi_end_xfer */
+static void spi_wait_xfer_gap(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+
+    if (data->xfer_gap_us == 0) {
+        return;
+    }
+
+    // one cycle is not counted as elapsed, since a coarse cycle counter (e.g. a 32 kHz RTC) may
+    // have ticked right after the end of the transaction was stamped
+    uint32_t elapsed_cyc = k_cycle_get_32() - data->last_xfer_cyc;
+    uint32_t elapsed_us = elapsed_cyc > 0 ? k_cyc_to_us_floor32(elapsed_cyc - 1) : 0;
+
+    if (elapsed_us < data->xfer_gap_us) {
+        spi_busy_wait(dev, data->xfer_gap_us - elapsed_us);
+    }
+
+    data->xfer_gap_us = 0;
+}
+
+/* The bus lock is held for a whole transaction sequence. It is a semaphore rather than a mutex
+ * since an asynchronous motion burst releases it from the SPI completion callback. */
+static inline void bus_lock(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    k_sem_take(&data->bus_sem, K_FOREVER);
+}
+
+static inline void bus_unlock(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    k_sem_give(&data->bus_sem);
+}
+
+/* Whether an asynchronous motion burst holds the bus lock. It does so across work items of the
+ * motion work queue, so the other items of that queue must not wait for the lock then: the burst
+ * only completes once they return. They retry T_BUS_RETRY_US later instead. */
+static inline bool bus_held_by_burst(const struct device *dev) {
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+    struct pixart_data *data = dev->data;
+    return data->burst_state != BURST_IDLE;
+#else
+    ARG_UNUSED(dev);
+    return false;
+#endif
+}
+
 // checked and keep
 static int spi_cs_ctrl(const struct device *dev, bool enable) {
     const struct pixart_config *config = dev->config;
     int err;
 
-    if (!enable) {
-        k_busy_wait(T_NCS_SCLK);
+    if (enable) {
+        spi_wait_xfer_gap(dev);
+    } else {
+        spi_busy_wait(dev, T_NCS_SCLK);
     }
 
     err = gpio_pin_set_dt(&config->cs_gpio, (int)enable);
@@ -87,16 +221,16 @@ static int spi_cs_ctrl(const struct device *dev, bool enable) {
     }
 
     if (enable) {
-        k_busy_wait(T_NCS_SCLK);
+        spi_busy_wait(dev, T_NCS_SCLK);
     }
 
     return err;
 }
 
-// checked and keep
-static int reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
+// primitive read without taking the bus lock
+static int _reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
     int err;
-    /* struct pixart_data *data = dev->data; */
+    struct pixart_data *data = dev->data;
     const struct pixart_config *config = dev->config;
 
     __ASSERT_NO_MSG((reg & SPI_WRITE_BIT) == 0);
@@ -113,10 +247,11 @@ static int reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
     err = spi_write_dt(&config->bus, &tx);
     if (err) {
         LOG_ERR("Reg read failed on SPI write");
+        PMW3610_STATS_INC(data, spi_err_reg_read);
         return err;
     }
 
-    k_busy_wait(T_SRAD);
+    spi_busy_wait(dev, T_SRAD);
 
     /* Read register value. */
     struct spi_buf rx_buf = {
@@ -131,6 +266,7 @@ static int reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
     err = spi_read_dt(&config->bus, &rx);
     if (err) {
         LOG_ERR("Reg read failed on SPI read");
+        PMW3610_STATS_INC(data, spi_err_reg_read);
         return err;
     }
 
@@ -139,15 +275,23 @@ static int reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
         return err;
     }
 
-    k_busy_wait(T_SRX);
+    spi_end_xfer(dev, T_SRX);
 
     return 0;
 }
 
+static int reg_read(const struct device *dev, uint8_t reg, uint8_t *buf) {
+    bus_lock(dev);
+    int err = _reg_read(dev, reg, buf);
+    bus_unlock(dev);
+
+    return err;
+}
+
 // primitive write without enable/disable spi clock on the sensor
 static int _reg_write(const struct device *dev, uint8_t reg, uint8_t val) {
     int err;
-    /* struct pixart_data *data = dev->data; */
+    struct pixart_data *data = dev->data;
     const struct pixart_config *config = dev->config;
 
     __ASSERT_NO_MSG((reg & SPI_WRITE_BIT) == 0);
@@ -164,48 +308,25 @@ static int _reg_write(const struct device *dev, uint8_t reg, uint8_t val) {
     err = spi_write_dt(&config->bus, &tx);
     if (err) {
         LOG_ERR("Reg write failed on SPI write");
+        PMW3610_STATS_INC(data, spi_err_reg_write);
         return err;
     }
 
-    k_busy_wait(T_SCLK_NCS_WR);
+    spi_busy_wait(dev, T_SCLK_NCS_WR);
 
     err = spi_cs_ctrl(dev, false);
     if (err) {
         return err;
     }
 
-    k_busy_wait(T_SWX);
-
-    return 0;
-}
-
-static int reg_write(const struct device *dev, uint8_t reg, uint8_t val) {
-    int err;
-
-    // enable spi clock
-    err = _reg_write(dev, PMW3610_REG_SPI_CLK_ON_REQ, PMW3610_SPI_CLOCK_CMD_ENABLE);
-    if (unlikely(err != 0)) {
-        return err;
-    }
-
-    // write the target register
-    err = _reg_write(dev, reg, val);
-    if (unlikely(err != 0)) {
-        return err;
-    }
-
-    // disable spi clock to save power
-    err = _reg_write(dev, PMW3610_REG_SPI_CLK_ON_REQ, PMW3610_SPI_CLOCK_CMD_DISABLE);
-    if (unlikely(err != 0)) {
-        return err;
-    }
+    spi_end_xfer(dev, T_SWX);
 
     return 0;
 }
 
-static int motion_burst_read(const struct device *dev, uint8_t *buf, size_t burst_size) {
+static int _motion_burst_read(const struct device *dev, uint8_t *buf, size_t burst_size) {
     int err;
-    /* struct pixart_data *data = dev->data; */
+    struct pixart_data *data = dev->data;
     const struct pixart_config *config = dev->config;
 
     __ASSERT_NO_MSG(burst_size <= PMW3610_MAX_BURST_SIZE);
@@ -223,10 +344,11 @@ static int motion_burst_read(const struct device *dev, uint8_t *buf, size_t burs
     err = spi_write_dt(&config->bus, &tx);
     if (err) {
         LOG_ERR("Motion burst failed on SPI write");
+        PMW3610_STATS_INC(data, spi_err_burst_read);
         return err;
     }
 
-    k_busy_wait(T_SRAD_MOTBR);
+    spi_busy_wait(dev, T_SRAD_MOTBR);
 
     const struct spi_buf rx_buf = {
         .buf = buf,
@@ -237,6 +359,7 @@ static int motion_burst_read(const struct device *dev, uint8_t *buf, size_t burs
     err = spi_read_dt(&config->bus, &rx);
     if (err) {
         LOG_ERR("Motion burst failed on SPI read");
+        PMW3610_STATS_INC(data, spi_err_burst_read);
         return err;
     }
 
@@ -246,11 +369,104 @@ static int motion_burst_read(const struct device *dev, uint8_t *buf, size_t burs
     }
 
     /* Terminate burst */
-    k_busy_wait(T_BEXIT);
+    spi_end_xfer(dev, T_BEXIT);
 
+    PMW3610_STATS_INC(data, bursts);
     return 0;
 }
 
+static int motion_burst_read(const struct device *dev, uint8_t *buf, size_t burst_size) {
+    bus_lock(dev);
+    int err = _motion_burst_read(dev, buf, burst_size);
+    bus_unlock(dev);
+
+    return err;
+}
+
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+/* Asynchronous motion burst. The address and data phases are separate SPI transfers, since the
+ * sensor needs T_SRAD_MOTBR in between. Each phase is started from the work queue and completes
+ * in motion_burst_async_cb, which resubmits the trigger work to run the next step. No thread
+ * blocks on the bus while a transfer is in flight. */
+static void motion_burst_async_cb(const struct device *spi, int result, void *user_data) {
+    struct pixart_data *data = user_data;
+    const struct device *dev = data->dev;
+
+    if (result < 0 || data->burst_state == BURST_DATA_PENDING) {
+        // burst finished (or failed), release the sensor and the bus
+        spi_cs_ctrl(dev, false);
+        spi_end_xfer(dev, T_BEXIT);
+        bus_unlock(dev);
+
+        data->burst_err = result;
+        data->burst_state = BURST_DATA_DONE;
+        if (result < 0) {
+            PMW3610_STATS_INC(data, spi_err_burst_read);
+        } else {
+            PMW3610_STATS_INC(data, bursts);
+        }
+    } else {
+        // address sent, T_SRAD_MOTBR is waited for when starting the data phase
+        spi_end_xfer(dev, T_SRAD_MOTBR);
+        data->burst_state = BURST_ADDR_DONE;
+    }
+
+    pmw3610_submit_work(&data->trigger_work);
+}
+
+static int motion_burst_async_step(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    const struct pixart_config *config = dev->config;
+    int err;
+
+    switch (data->burst_state) {
+    case BURST_IDLE:
+        bus_lock(dev);
+
+        err = spi_cs_ctrl(dev, true);
+        if (err) {
+            break;
+        }
+
+        /* Send motion burst address */
+        data->burst_addr = PMW3610_REG_MOTION_BURST;
+        data->burst_spi_buf.buf = &data->burst_addr;
+        data->burst_spi_buf.len = 1;
+        data->burst_spi_set.buffers = &data->burst_spi_buf;
+        data->burst_spi_set.count = 1;
+
+        data->burst_state = BURST_ADDR_PENDING;
+        err = spi_transceive_cb(config->bus.bus, &config->bus.config, &data->burst_spi_set, NULL,
+                                motion_burst_async_cb, data);
+        break;
+
+    case BURST_ADDR_DONE:
+        spi_wait_xfer_gap(dev);
+
+        data->burst_spi_buf.buf = data->burst_buf;
+        data->burst_spi_buf.len = PMW3610_BURST_SIZE;
+
+        data->burst_state = BURST_DATA_PENDING;
+        err = spi_transceive_cb(config->bus.bus, &config->bus.config, NULL, &data->burst_spi_set,
+                                motion_burst_async_cb, data);
+        break;
+
+    default:
+        return -EALREADY;
+    }
+
+    if (err) {
+        LOG_ERR("Motion burst failed on async SPI transfer");
+        PMW3610_STATS_INC(data, spi_err_burst_read);
+        spi_cs_ctrl(dev, false);
+        bus_unlock(dev);
+        data->burst_state = BURST_IDLE;
+    }
+
+    return err;
+}
+#endif
+
 /** Writing an array of registers in sequence, used in power-up register initialization and running
  * mode switching */
 static int burst_write(const struct device *dev, const uint8_t *addr, const uint8_t *buf,
@@ -282,171 +498,493 @@ static int burst_write(const struct device *dev, const uint8_t *addr, const uint
     return 0;
 }
 
-static int check_product_id(const struct device *dev) {
-    uint8_t product_id = 0x01;
-    int err = reg_read(dev, PMW3610_REG_PRODUCT_ID, &product_id);
-    if (err) {
-        LOG_ERR("Cannot obtain product id");
-        return err;
+//////// Register shadow //////////
+// The configuration registers are shadowed, so that writes which would not change //
+// anything are skipped, and so that a reset of the sensor (ESD, brown-out) can be  //
+// detected by reading them back and fixed by rewriting only what differs.         //
+static const uint8_t shadow_regs[PIXART_SHADOW_SIZE] = {
+    PMW3610_REG_PERFORMANCE,
+    PMW3610_REG_RUN_DOWNSHIFT,
+    PMW3610_REG_REST1_PERIOD,
+    PMW3610_REG_REST1_DOWNSHIFT,
+    PMW3610_REG_REST2_PERIOD,
+    PMW3610_REG_REST2_DOWNSHIFT,
+    PMW3610_REG_REST3_PERIOD,
+    PMW3610_REG_RES_STEP,
+    PMW3610_REG_SMART_MODE,
+};
+
+static void shadow_init(struct pixart_data *data) {
+    for (size_t i = 0; i < PIXART_SHADOW_SIZE; i++) {
+        data->shadow[i].reg = shadow_regs[i];
+        data->shadow[i].state = SHADOW_UNSET;
     }
+}
 
-    if (product_id != PMW3610_PRODUCT_ID) {
-        LOG_ERR("Incorrect product id 0x%x (expecting 0x%x)!", product_id, PMW3610_PRODUCT_ID);
-        return -EIO;
+static struct pixart_reg_shadow *shadow_find(struct pixart_data *data, uint8_t reg) {
+    for (size_t i = 0; i < PIXART_SHADOW_SIZE; i++) {
+        if (data->shadow[i].reg == reg) {
+            return &data->shadow[i];
+        }
     }
 
-    return 0;
+    return NULL;
 }
 
-static int set_cpi(const struct device *dev, uint32_t cpi) {
-    /* Set resolution with CPI step of 200 cpi
-     * 0x1: 200 cpi (minimum cpi)
-     * 0x2: 400 cpi
-     * 0x3: 600 cpi
-     * :
-     */
-
-    if ((cpi > PMW3610_MAX_CPI) || (cpi < PMW3610_MIN_CPI)) {
-        LOG_ERR("CPI value %u out of range", cpi);
-        return -EINVAL;
+/* The sensor lost (or may have lost) its configuration, e.g. on a power-up reset */
+static void shadow_invalidate(struct pixart_data *data) {
+    for (size_t i = 0; i < PIXART_SHADOW_SIZE; i++) {
+        if (data->shadow[i].state == SHADOW_SYNCED) {
+            data->shadow[i].state = SHADOW_PENDING;
+        }
     }
+}
 
-    // Convert CPI to register value
-    uint8_t value = (cpi / 200);
-    LOG_INF("Setting CPI to %u (reg value 0x%x)", cpi, value);
+//////// Register write sessions //////////
+// The sensor only accepts writes while its SPI clock is on. A session queues a //
+// sequence of writes and commits them with a single clock-on/clock-off pair.   //
+struct reg_write_session {
+    struct pixart_data *data;
+    uint8_t addr[PMW3610_SESSION_MAX_WRITES];
+    uint8_t val[PMW3610_SESSION_MAX_WRITES];
+    size_t len;
+    bool page1;           // sensor is left on page 1 by the queued writes
+    int err;              // first queueing error, reported on commit
+    uint16_t shadow_mask; // shadow entries queued by the session, synced on commit
+};
 
-    /* set the cpi */
-    uint8_t addr[] = {0x7F, PMW3610_REG_RES_STEP, 0x7F};
-    uint8_t data[] = {0xFF, value, 0x00};
-    int err = burst_write(dev, addr, data, 3);
-    if (err) {
-        LOG_ERR("Failed to set CPI");
-        return err;
+BUILD_ASSERT(PIXART_SHADOW_SIZE <= 16, "reg_write_session.shadow_mask is too small");
+
+static void session_open(struct reg_write_session *session, const struct device *dev) {
+    session->data = dev->data;
+    session->len = 0;
+    session->page1 = false;
+    session->err = 0;
+    session->shadow_mask = 0;
+}
+
+static int session_queue_raw(struct reg_write_session *session, uint8_t reg, uint8_t val) {
+    if (session->err) {
+        return session->err;
+    }
+
+    if (session->len >= PMW3610_SESSION_MAX_WRITES) {
+        LOG_ERR("Write session overflow");
+        session->err = -ENOMEM;
+        return session->err;
     }
 
-    struct pixart_data *dev_data = dev->data;
-    dev_data->curr_cpi = cpi;
+    // the page bit is only meaningful to the session, the wire address is always 7-bit
+    session->addr[session->len] = reg & ~PMW3610_PAGE1_BIT;
+    session->val[session->len] = val;
+    session->len++;
 
     return 0;
 }
 
-static int set_cpi_if_needed(const struct device *dev, uint32_t cpi) {
-    struct pixart_data *data = dev->data;
-    if (cpi != data->curr_cpi) {
-        return set_cpi(dev, cpi);
+/** Queue a register write, switching the register page first when needed. A shadowed register
+ * already holding the value is skipped. */
+static int session_queue(struct reg_write_session *session, uint8_t reg, uint8_t val) {
+    struct pixart_reg_shadow *shadow = shadow_find(session->data, reg);
+    bool page1 = (reg & PMW3610_PAGE1_BIT) != 0;
+
+    if (shadow != NULL) {
+        if (shadow->state == SHADOW_SYNCED && shadow->val == val) {
+            return 0;
+        }
+
+        // synced again once the session is committed
+        shadow->val = val;
+        shadow->state = SHADOW_PENDING;
+        session->shadow_mask |= BIT(shadow - session->data->shadow);
     }
-    return 0;
+
+    if (page1 != session->page1) {
+        session_queue_raw(session, page1 ? PMW3610_REG_SPI_PAGE0 : PMW3610_REG_SPI_PAGE1,
+                          page1 ? PMW3610_SPI_PAGE_CMD_PAGE1 : PMW3610_SPI_PAGE_CMD_PAGE0);
+        session->page1 = page1;
+    }
+
+    return session_queue_raw(session, reg, val);
 }
 
-/* Set sampling rate in each mode (in ms) */
-static int set_sample_time(const struct device *dev, uint8_t reg_addr, uint32_t sample_time) {
-    uint32_t maxtime = 2550;
-    uint32_t mintime = 10;
-    if ((sample_time > maxtime) || (sample_time < mintime)) {
-        LOG_WRN("Sample time %u out of range [%u, %u]", sample_time, mintime, maxtime);
-        return -EINVAL;
+/** Write all queued registers, always leaving the sensor on page 0 */
+static int session_commit(const struct device *dev, struct reg_write_session *session) {
+    struct pixart_data *data = dev->data;
+
+    if (session->page1) {
+        session_queue_raw(session, PMW3610_REG_SPI_PAGE1, PMW3610_SPI_PAGE_CMD_PAGE0);
+        session->page1 = false;
     }
 
-    uint8_t value = sample_time / mintime;
-    LOG_INF("Set sample time to %u ms (reg value: 0x%x)", sample_time, value);
+    if (session->err) {
+        return session->err;
+    }
 
-    /* The sample time is (reg_value * mintime ) ms. 0x00 is rounded to 0x1 */
-    int err = reg_write(dev, reg_addr, value);
-    if (err) {
-        LOG_ERR("Failed to change sample time");
+    if (session->len == 0) {
+        return 0;
+    }
+
+    bus_lock(dev);
+    int err = burst_write(dev, session->addr, session->val, session->len);
+    bus_unlock(dev);
+
+    // on failure, the pending registers are written again by the next session or restore. The
+    // entries left pending by another (failed) session are not written by this one.
+    if (!err) {
+        for (size_t i = 0; i < PIXART_SHADOW_SIZE; i++) {
+            if ((session->shadow_mask & BIT(i)) && data->shadow[i].state == SHADOW_PENDING) {
+                data->shadow[i].state = SHADOW_SYNCED;
+            }
+        }
     }
 
     return err;
 }
 
-/* Set downshift time in ms. */
-// NOTE: The unit of run-mode downshift is related to pos mode rate, which is hard coded to be 4 ms
-// The pos-mode rate is configured in pmw3610_async_init_configure
-static int set_downshift_time(const struct device *dev, uint8_t reg_addr, uint32_t time) {
-    uint32_t maxtime;
-    uint32_t mintime;
+static int reg_write(const struct device *dev, uint8_t reg, uint8_t val) {
+    struct reg_write_session session;
 
-    switch (reg_addr) {
-    case PMW3610_REG_RUN_DOWNSHIFT:
-        /*
-         * Run downshift time = PMW3610_REG_RUN_DOWNSHIFT
-         *                      * 8 * pos-rate (fixed to 4ms)
-         */
-        maxtime = 32 * 255;
-        mintime = 32; // hard-coded in pmw3610_async_init_configure
-        break;
+    session_open(&session, dev);
+    session_queue(&session, reg, val);
 
-    case PMW3610_REG_REST1_DOWNSHIFT:
-        /*
-         * Rest1 downshift time = PMW3610_REG_RUN_DOWNSHIFT
-         *                        * 16 * Rest1_sample_period (default 40 ms)
-         */
-        maxtime = 255 * 16 * CONFIG_PMW3610_REST1_SAMPLE_TIME_MS;
-        mintime = 16 * CONFIG_PMW3610_REST1_SAMPLE_TIME_MS;
-        break;
+    return session_commit(dev, &session);
+}
 
-    case PMW3610_REG_REST2_DOWNSHIFT:
-        /*
-         * Rest2 downshift time = PMW3610_REG_REST2_DOWNSHIFT
-         *                        * 128 * Rest2 rate (default 100 ms)
-         */
-        maxtime = 255 * 128 * CONFIG_PMW3610_REST2_SAMPLE_TIME_MS;
-        mintime = 128 * CONFIG_PMW3610_REST2_SAMPLE_TIME_MS;
-        break;
+/** Read a register of either page, page 1 registers being addressed with PMW3610_PAGE1_BIT */
+static int reg_read_paged(const struct device *dev, uint8_t reg, uint8_t *val) {
+    if (!(reg & PMW3610_PAGE1_BIT)) {
+        return reg_read(dev, reg, val);
+    }
 
-    default:
-        LOG_ERR("Not supported");
-        return -ENOTSUP;
+    bus_lock(dev);
+
+    int err = _reg_write(dev, PMW3610_REG_SPI_CLK_ON_REQ, PMW3610_SPI_CLOCK_CMD_ENABLE);
+    if (!err) {
+        err = _reg_write(dev, PMW3610_REG_SPI_PAGE0, PMW3610_SPI_PAGE_CMD_PAGE1);
+    }
+    if (!err) {
+        err = _reg_read(dev, reg & ~PMW3610_PAGE1_BIT, val);
     }
 
-    if ((time > maxtime) || (time < mintime)) {
-        LOG_WRN("Downshift time %u out of range", time);
-        return -EINVAL;
+    // always try to get back to page 0 and to gate the clock again
+    int err2 = _reg_write(dev, PMW3610_REG_SPI_PAGE1 & ~PMW3610_PAGE1_BIT,
+                          PMW3610_SPI_PAGE_CMD_PAGE0);
+    if (!err2) {
+        err2 = _reg_write(dev, PMW3610_REG_SPI_CLK_ON_REQ, PMW3610_SPI_CLOCK_CMD_DISABLE);
     }
 
-    __ASSERT_NO_MSG((mintime > 0) && (maxtime / mintime <= UINT8_MAX));
+    bus_unlock(dev);
 
-    /* Convert time to register value */
-    uint8_t value = time / mintime;
+    return err ? err : err2;
+}
 
-    LOG_INF("Set downshift time to %u ms (reg value 0x%x)", time, value);
+int pmw3610_reg_read(const struct device *dev, uint8_t reg, uint8_t *val) {
+    struct pixart_data *data = dev->data;
 
-    int err = reg_write(dev, reg_addr, value);
-    if (err) {
-        LOG_ERR("Failed to change downshift time");
+    if (!data->ready) {
+        return -EBUSY;
     }
 
-    return err;
+    return reg_read_paged(dev, reg, val);
 }
 
-static void set_interrupt(const struct device *dev, const bool en) {
-    const struct pixart_config *config = dev->config;
-    int ret = gpio_pin_interrupt_configure_dt(&config->irq_gpio,
-                                              en ? GPIO_INT_LEVEL_ACTIVE : GPIO_INT_DISABLE);
-    if (ret < 0) {
-        LOG_ERR("can't set interrupt");
-    }
-}
+int pmw3610_reg_write(const struct device *dev, uint8_t reg, uint8_t val) {
+    struct pixart_data *data = dev->data;
 
-static int pmw3610_async_init_power_up(const struct device *dev) {
-    LOG_INF("async_init_power_up");
+    // the page selection is tracked by the sessions, and the cpi is scaled by the driver: a raw
+    // write would leave both stale
+    if (reg == PMW3610_REG_SPI_PAGE0 || reg == PMW3610_REG_SPI_PAGE1 ||
+        reg == PMW3610_REG_RES_STEP) {
+        return -EPERM;
+    }
 
-    /* Reset spi port */
-    spi_cs_ctrl(dev, false);
-    spi_cs_ctrl(dev, true);
+    if (!data->ready) {
+        return -EBUSY;
+    }
 
-    /* not required in datashet, but added any way to have a clear state */
-    return reg_write(dev, PMW3610_REG_POWER_UP_RESET, PMW3610_POWERUP_CMD_RESET);
+    return reg_write(dev, reg, val);
 }
 
-static int pmw3610_async_init_clear_ob1(const struct device *dev) {
-    LOG_INF("async_init_clear_ob1");
+/** Read the shadowed registers back and rewrite the ones which differ, in a single session.
+ * Returns the number of registers restored, or a negative error code. */
+static int shadow_verify_restore(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    struct reg_write_session session;
+    int restored = 0;
+
+    session_open(&session, dev);
+
+    for (size_t i = 0; i < PIXART_SHADOW_SIZE; i++) {
+        struct pixart_reg_shadow *shadow = &data->shadow[i];
+        uint8_t val;
+
+        if (shadow->state == SHADOW_UNSET) {
+            continue;
+        }
+
+        int err = reg_read_paged(dev, shadow->reg, &val);
+        if (err) {
+            return err;
+        }
+
+        if (shadow->state == SHADOW_SYNCED && val == shadow->val) {
+            continue;
+        }
+
+        LOG_WRN("Register 0x%02x is 0x%02x instead of 0x%02x, restoring", shadow->reg, val,
+                shadow->val);
+        shadow->state = SHADOW_PENDING;
+        session_queue(&session, shadow->reg, shadow->val);
+        restored++;
+    }
+
+    int err = session_commit(dev, &session);
+    if (err) {
+        return err;
+    }
+
+    PMW3610_STATS_ADD(data, reg_restores, restored);
+    return restored;
+}
+
+static int check_product_id(const struct device *dev) {
+    uint8_t product_id = 0x01;
+    int err = reg_read(dev, PMW3610_REG_PRODUCT_ID, &product_id);
+    if (err) {
+        LOG_ERR("Cannot obtain product id");
+        return err;
+    }
+
+    if (product_id != PMW3610_PRODUCT_ID) {
+        LOG_ERR("Incorrect product id 0x%x (expecting 0x%x)!", product_id, PMW3610_PRODUCT_ID);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+static int queue_cpi(struct reg_write_session *session, uint32_t cpi) {
+    /* Set resolution with CPI step of 200 cpi (PMW3610_CPI_STEP)
+     * 0x1: 200 cpi (minimum cpi)
+     * 0x2: 400 cpi
+     * 0x3: 600 cpi
+     * :
+     */
+
+    if ((cpi > PMW3610_MAX_CPI) || (cpi < PMW3610_MIN_CPI)) {
+        LOG_ERR("CPI value %u out of range", cpi);
+        return -EINVAL;
+    }
+
+    // Convert CPI to register value
+    uint8_t value = (cpi / PMW3610_CPI_STEP);
+    LOG_DBG("Setting CPI to %u (reg value 0x%x)", cpi, value);
+
+    // the session takes care of the page switch around the page 1 register
+    return session_queue(session, PMW3610_REG_RES_STEP, value);
+}
+
+/* Cpi of an input mode, the SNIPE mode has its own */
+static uint32_t cpi_for_mode(const struct pixart_data *data, enum pixart_input_mode mode) {
+    return mode == SNIPE ? data->snipe_cpi : data->cpi;
+}
+
+/* Register value of a rest sample time (in ms) */
+static int sample_time_value(uint32_t sample_time, uint8_t *value) {
+    uint32_t maxtime = 2550;
+    uint32_t mintime = 10;
+    if ((sample_time > maxtime) || (sample_time < mintime)) {
+        LOG_WRN("Sample time %u out of range [%u, %u]", sample_time, mintime, maxtime);
+        return -EINVAL;
+    }
+
+    *value = sample_time / mintime;
+    return 0;
+}
+
+/* Set sampling rate in each mode (in ms) */
+static int queue_sample_time(struct reg_write_session *session, uint8_t reg_addr,
+                             uint32_t sample_time) {
+    uint8_t value;
+    int err = sample_time_value(sample_time, &value);
+    if (err) {
+        return err;
+    }
+
+    LOG_DBG("Set sample time to %u ms (reg value: 0x%x)", sample_time, value);
+
+    /* The sample time is (reg_value * mintime ) ms. 0x00 is rounded to 0x1 */
+    return session_queue(session, reg_addr, value);
+}
+
+/* Unit (in ms) of a downshift register, given the sample time of its mode. 0 if not supported. */
+// NOTE: The unit of run-mode downshift is related to pos mode rate, which is hard coded to be 4 ms
+// The pos-mode rate is configured in pmw3610_async_init_configure
+static uint32_t downshift_unit(uint8_t reg_addr, uint32_t sample_time) {
+    switch (reg_addr) {
+    case PMW3610_REG_RUN_DOWNSHIFT:
+        /*
+         * Run downshift time = PMW3610_REG_RUN_DOWNSHIFT
+         *                      * 8 * pos-rate (fixed to 4ms)
+         */
+        return 32;
+
+    case PMW3610_REG_REST1_DOWNSHIFT:
+        /*
+         * Rest1 downshift time = PMW3610_REG_RUN_DOWNSHIFT
+         *                        * 16 * Rest1_sample_period (default 40 ms)
+         */
+        return 16 * sample_time;
+
+    case PMW3610_REG_REST2_DOWNSHIFT:
+        /*
+         * Rest2 downshift time = PMW3610_REG_REST2_DOWNSHIFT
+         *                        * 128 * Rest2 rate (default 100 ms)
+         */
+        return 128 * sample_time;
+
+    default:
+        return 0;
+    }
+}
+
+/* Register value of a downshift time (in ms), given the sample time of its mode (see
+ * downshift_unit) */
+static int downshift_time_value(uint8_t reg_addr, uint32_t time, uint32_t sample_time,
+                                uint8_t *value) {
+    uint32_t mintime = downshift_unit(reg_addr, sample_time);
+    uint32_t maxtime = 255 * mintime;
+
+    if (mintime == 0) {
+        LOG_WRN("Sample time of the downshift 0x%x unknown, set it first", reg_addr);
+        return -EINVAL;
+    }
+
+    if ((time > maxtime) || (time < mintime)) {
+        LOG_WRN("Downshift time %u out of range", time);
+        return -EINVAL;
+    }
+
+    /* Convert time to register value */
+    *value = time / mintime;
+    return 0;
+}
+
+/* Set downshift time in ms. */
+// The rest downshift times are counted in samples of their mode, so the runtime sample time of
+// that mode is used for the conversion.
+static int queue_downshift_time(struct reg_write_session *session, uint8_t reg_addr,
+                                uint32_t time) {
+    uint32_t sample_time = 0;
+    uint8_t value;
+
+    if (reg_addr == PMW3610_REG_REST1_DOWNSHIFT) {
+        sample_time = session->data->rest1_sample_ms;
+    } else if (reg_addr == PMW3610_REG_REST2_DOWNSHIFT) {
+        sample_time = session->data->rest2_sample_ms;
+    }
+
+    int err = downshift_time_value(reg_addr, time, sample_time, &value);
+    if (err) {
+        return err;
+    }
+
+    LOG_DBG("Set downshift time to %u ms (reg value 0x%x)", time, value);
+
+    return session_queue(session, reg_addr, value);
+}
+
+/* Queue the runtime settings, everything of the run configuration but the cpi. The session skips
+ * the registers already holding their value. */
+static int queue_settings(struct reg_write_session *session) {
+    struct pixart_data *data = session->data;
+
+    // set performace register: run mode, vel_rate, poshi_rate, poslo_rate
+    uint8_t value = PMW3610_PERFORMANCE_VALUE(data->force_awake);
+    int err = session_queue(session, PMW3610_REG_PERFORMANCE, value);
+    LOG_DBG("Set performance register (reg value 0x%x)", value);
+
+    // required downshift and rate registers
+    if (!err) {
+        err = queue_downshift_time(session, PMW3610_REG_RUN_DOWNSHIFT, data->run_downshift_ms);
+    }
+    if (!err) {
+        err = queue_sample_time(session, PMW3610_REG_REST1_PERIOD, data->rest1_sample_ms);
+    }
+    if (!err) {
+        err = queue_downshift_time(session, PMW3610_REG_REST1_DOWNSHIFT,
+                                   data->rest1_downshift_ms);
+    }
+
+    // sample and downshift time for each rest mode, the sample time first since it is the unit
+    // of the downshift time
+    if (!err && data->rest2_sample_ms != 0) {
+        err = queue_sample_time(session, PMW3610_REG_REST2_PERIOD, data->rest2_sample_ms);
+    }
+    if (!err && data->rest2_downshift_ms != 0) {
+        err = queue_downshift_time(session, PMW3610_REG_REST2_DOWNSHIFT,
+                                   data->rest2_downshift_ms);
+    }
+    if (!err && data->rest3_sample_ms != 0) {
+        err = queue_sample_time(session, PMW3610_REG_REST3_PERIOD, data->rest3_sample_ms);
+    }
+
+    return err;
+}
+
+static void set_interrupt(const struct device *dev, const bool en) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+
+    // a suspended sensor is not armed, whatever work item was still running
+    if (pmw3610_polling(dev) || (en && data->suspended)) {
+        return;
+    }
+
+    int ret = gpio_pin_interrupt_configure_dt(&config->irq_gpio,
+                                              en ? GPIO_INT_LEVEL_ACTIVE : GPIO_INT_DISABLE);
+    if (ret < 0) {
+        LOG_ERR("can't set interrupt");
+    }
+}
+
+static int pmw3610_async_init_power_up(const struct device *dev) {
+    LOG_INF("async_init_power_up");
+
+    /* Reset spi port */
+    spi_cs_ctrl(dev, false);
+    spi_cs_ctrl(dev, true);
+
+    // the reset brings every register back to its default
+    shadow_invalidate(dev->data);
+
+    /* not required in datashet, but added any way to have a clear state */
+    return reg_write(dev, PMW3610_REG_POWER_UP_RESET, PMW3610_POWERUP_CMD_RESET);
+}
+
+static int pmw3610_async_init_clear_ob1(const struct device *dev) {
+    LOG_DBG("async_init_clear_ob1");
+
+    // the id registers read back correctly once the power-up reset is done
+    uint8_t product_id, not_product_id;
+    int err = reg_read(dev, PMW3610_REG_PRODUCT_ID, &product_id);
+    if (!err) {
+        err = reg_read(dev, PMW3610_REG_NOT_PROD_ID, &not_product_id);
+    }
+    if (err) {
+        return err;
+    }
+
+    if (product_id != PMW3610_PRODUCT_ID || (uint8_t)~not_product_id != PMW3610_PRODUCT_ID) {
+        return -EAGAIN;
+    }
 
     return reg_write(dev, PMW3610_REG_OBSERVATION, 0x00);
 }
 
 static int pmw3610_async_init_check_ob1(const struct device *dev) {
-    LOG_INF("async_init_check_ob1");
+    LOG_DBG("async_init_check_ob1");
 
     uint8_t value;
     int err = reg_read(dev, PMW3610_REG_OBSERVATION, &value);
@@ -455,9 +993,10 @@ static int pmw3610_async_init_check_ob1(const struct device *dev) {
         return err;
     }
 
+    // the sensor sets the bits back once the self-test ran
     if ((value & 0x0F) != 0x0F) {
-        LOG_ERR("Failed self-test (0x%x)", value);
-        return -EINVAL;
+        LOG_DBG("Self-test pending (0x%x)", value);
+        return -EAGAIN;
     }
 
     err = check_product_id(dev);
@@ -469,180 +1008,320 @@ static int pmw3610_async_init_check_ob1(const struct device *dev) {
     return 0;
 }
 
-static int pmw3610_async_init_configure(const struct device *dev) {
-    LOG_INF("async_init_configure");
-
+/* Read the motion registers, which clears them */
+static int clear_motion_regs(const struct device *dev) {
     int err = 0;
 
-    // clear motion registers first (required in datasheet)
-    for (uint8_t reg = 0x02; (reg <= 0x05) && !err; reg++) {
+    for (uint8_t reg = PMW3610_REG_MOTION; (reg <= PMW3610_REG_DELTA_XY_H) && !err; reg++) {
         uint8_t buf[1];
         err = reg_read(dev, reg, buf);
     }
 
-    // cpi
-    if (!err) {
-        err = set_cpi(dev, CONFIG_PMW3610_CPI);
-    }
+    return err;
+}
 
-    // set performace register: run mode, vel_rate, poshi_rate, poslo_rate
-    if (!err) {
-        err = reg_write(dev, PMW3610_REG_PERFORMANCE, PMW3610_PERFORMANCE_VALUE);
-        LOG_INF("Set performance register (reg value 0x%x)", PMW3610_PERFORMANCE_VALUE);
-    }
+/* Clear the motion registers and write the whole run configuration, used at init */
+static int pmw3610_write_config(const struct device *dev, uint32_t cpi) {
+    struct pixart_data *data = dev->data;
 
-    // required downshift and rate registers
-    if (!err) {
-        err = set_downshift_time(dev, PMW3610_REG_RUN_DOWNSHIFT,
-                                 CONFIG_PMW3610_RUN_DOWNSHIFT_TIME_MS);
-    }
-    if (!err) {
-        err = set_sample_time(dev, PMW3610_REG_REST1_PERIOD, CONFIG_PMW3610_REST1_SAMPLE_TIME_MS);
-    }
-    if (!err) {
-        err = set_downshift_time(dev, PMW3610_REG_REST1_DOWNSHIFT,
-                                 CONFIG_PMW3610_REST1_DOWNSHIFT_TIME_MS);
-    }
+    // clear motion registers first (required in datasheet)
+    int err = clear_motion_regs(dev);
+
+    // queue all configuration registers, they are written with a single spi clock session
+    struct reg_write_session session;
+    session_open(&session, dev);
 
-    // downshift time for each rest mode
-#if CONFIG_PMW3610_REST2_DOWNSHIFT_TIME_MS > 0
     if (!err) {
-        err = set_downshift_time(dev, PMW3610_REG_REST2_DOWNSHIFT,
-                                 CONFIG_PMW3610_REST2_DOWNSHIFT_TIME_MS);
+        err = queue_cpi(&session, cpi);
     }
-#endif
-#if CONFIG_PMW3610_REST2_SAMPLE_TIME_MS >= 10
     if (!err) {
-        err = set_sample_time(dev, PMW3610_REG_REST2_PERIOD, CONFIG_PMW3610_REST2_SAMPLE_TIME_MS);
+        err = queue_settings(&session);
     }
-#endif
-#if CONFIG_PMW3610_REST3_SAMPLE_TIME_MS >= 10
     if (!err) {
-        err = set_sample_time(dev, PMW3610_REG_REST3_PERIOD, CONFIG_PMW3610_REST3_SAMPLE_TIME_MS);
+        err = session_commit(dev, &session);
     }
-#endif
     if (err) {
         LOG_ERR("Config the sensor failed");
         return err;
     }
 
+    data->curr_cpi = cpi;
     return 0;
 }
 
+static int pmw3610_async_init_configure(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+
+    LOG_INF("async_init_configure");
+
+    return pmw3610_write_config(dev, cpi_for_mode(data, data->active_layer_mode->mode));
+}
+
+#if CONFIG_PMW3610_REG_CHECK_INTERVAL_MS > 0
+/* Periodic readback of the configuration, catching a reset of the sensor by ESD or brown-out */
+static void pmw3610_reg_check_work_callback(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *data = CONTAINER_OF(dwork, struct pixart_data, reg_check_work);
+
+    if (!data->ready) {
+        return;
+    }
+
+    if (bus_held_by_burst(data->dev)) {
+        pmw3610_schedule_work(&data->reg_check_work, K_USEC(T_BUS_RETRY_US));
+        return;
+    }
+
+    int ret = shadow_verify_restore(data->dev);
+    if (ret < 0) {
+        LOG_ERR("Register check failed: %d", ret);
+    }
+
+    pmw3610_schedule_work(&data->reg_check_work, K_MSEC(CONFIG_PMW3610_REG_CHECK_INTERVAL_MS));
+}
+#endif
+
 // checked and keep
+/* The sensor is ready to work: arm the motion path, and apply the settings, as the layer or the
+ * attributes may have changed meanwhile */
+static void pmw3610_start(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+
+    data->ready = true;
+#if CONFIG_PMW3610_REG_CHECK_INTERVAL_MS > 0
+    pmw3610_schedule_work(&data->reg_check_work, K_MSEC(CONFIG_PMW3610_REG_CHECK_INTERVAL_MS));
+#endif
+    set_interrupt(dev, true);
+    if (pmw3610_polling(dev)) {
+        // the idle backoff counts from now, not from boot or from before a suspend
+        data->poll_last_motion = k_uptime_get();
+        data->poll_interval_ms = CONFIG_PMW3610_POLL_INTERVAL_MIN_MS;
+        pmw3610_schedule_work(&data->poll_work, K_NO_WAIT);
+    }
+
+    pmw3610_schedule_work(&data->config_work, K_NO_WAIT);
+}
+
 static void pmw3610_async_init(struct k_work *work) {
     struct k_work_delayable *work2 = (struct k_work_delayable *)work;
     struct pixart_data *data = CONTAINER_OF(work2, struct pixart_data, init_work);
     const struct device *dev = data->dev;
-
-    LOG_INF("PMW3610 async init step %d", data->async_init_step);
+    int64_t now;
 
     data->err = async_init_fn[data->async_init_step](dev);
+    now = k_uptime_get();
+
+    if (data->err == -EAGAIN) {
+        if (now - data->init_step_start < CONFIG_PMW3610_INIT_TIMEOUT_MS) {
+            k_work_schedule(&data->init_work, K_MSEC(CONFIG_PMW3610_INIT_POLL_INTERVAL_MS));
+            return;
+        }
+
+        LOG_ERR("PMW3610 init step %d timed out", data->async_init_step);
+        data->err = -ETIMEDOUT;
+    }
+
     if (data->err) {
         LOG_ERR("PMW3610 initialization failed");
+        return;
+    }
+
+    LOG_INF("PMW3610 init step %d done in %lld ms", data->async_init_step,
+            now - data->init_step_start);
+    data->init_step_start = now;
+    data->async_init_step++;
+
+    if (data->async_init_step == ASYNC_INIT_STEP_COUNT) {
+        LOG_INF("PMW3610 initialized");
+        pmw3610_start(dev);
     } else {
-        data->async_init_step++;
+        k_work_schedule(&data->init_work, K_MSEC(async_init_delay[data->async_init_step]));
+    }
+}
 
-        if (data->async_init_step == ASYNC_INIT_STEP_COUNT) {
-            data->ready = true; // sensor is ready to work
-            LOG_INF("PMW3610 initialized");
-            set_interrupt(dev, true);
-        } else {
-            k_work_schedule(&data->init_work, K_MSEC(async_init_delay[data->async_init_step]));
+static void activate_automouse_layer(const struct device *dev) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+
+    data->automouse_triggered = true;
+    zmk_keymap_layer_activate(config->automouse_layer);
+    k_timer_start(&data->automouse_layer_timer, K_MSEC(CONFIG_PMW3610_AUTOMOUSE_TIMEOUT_MS),
+                  K_NO_WAIT);
+}
+
+static void deactivate_automouse_layer(struct k_timer *timer) {
+    struct pixart_data *data = CONTAINER_OF(timer, struct pixart_data, automouse_layer_timer);
+    const struct pixart_config *config = data->dev->config;
+
+    data->automouse_triggered = false;
+    zmk_keymap_layer_deactivate(config->automouse_layer);
+}
+
+/* Activate the automouse layer of the sensor, if any, on a large enough pointer motion */
+static void trigger_automouse_layer(const struct device *dev, int16_t x, int16_t y) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+
+    if (config->automouse_layer > 0 &&
+        (data->automouse_triggered ||
+         zmk_keymap_highest_layer_active() != config->automouse_layer) &&
+        (abs(x) + abs(y) > CONFIG_PMW3610_MOVEMENT_THRESHOLD)) {
+        activate_automouse_layer(dev);
+    }
+}
+
+/* Build the layer to input mode table. A layer listed for several modes gets the first of
+ * scroll, snipe and ball action, in ball action declaration order. */
+static void build_layer_modes(const struct device *dev) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+
+    for (size_t layer = 0; layer < ZMK_KEYMAP_LAYERS_LEN; layer++) {
+        data->layer_modes[layer].mode = MOVE;
+        data->layer_modes[layer].ball_action = -1;
+    }
+
+    // lowest precedence first, so that higher precedence entries overwrite it
+    for (size_t i = config->ball_actions_len; i-- > 0;) {
+        for (size_t j = 0; j < config->ball_actions[i]->layers_len; j++) {
+            uint8_t layer = config->ball_actions[i]->layers[j];
+            if (layer < ZMK_KEYMAP_LAYERS_LEN) {
+                data->layer_modes[layer].mode = BALL_ACTION;
+                data->layer_modes[layer].ball_action = i;
+            }
+        }
+    }
+    for (size_t i = 0; i < config->snipe_layers_len; i++) {
+        int32_t layer = config->snipe_layers[i];
+        if (layer >= 0 && layer < ZMK_KEYMAP_LAYERS_LEN) {
+            data->layer_modes[layer].mode = SNIPE;
+            data->layer_modes[layer].ball_action = -1;
+        }
+    }
+    for (size_t i = 0; i < config->scroll_layers_len; i++) {
+        int32_t layer = config->scroll_layers[i];
+        if (layer >= 0 && layer < ZMK_KEYMAP_LAYERS_LEN) {
+            data->layer_modes[layer].mode = SCROLL;
+            data->layer_modes[layer].ball_action = -1;
         }
     }
 }
 
-#define AUTOMOUSE_LAYER (DT_PROP(DT_DRV_INST(0), automouse_layer))
-#if AUTOMOUSE_LAYER > 0
-struct k_timer automouse_layer_timer;
-static bool automouse_triggered = false;
+/* Apply the runtime settings and the cpi of the active input mode. It runs on the motion work
+ * queue as soon as the layer or a setting changes, so the first motion frame in the new mode does
+ * not pay for the register writes, and only the registers whose value changed are written. */
+static void pmw3610_config_work_callback(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *data = CONTAINER_OF(dwork, struct pixart_data, config_work);
+    const struct device *dev = data->dev;
+
+    // not initialized or suspended, the settings are applied once the sensor is ready
+    if (!data->ready) {
+        return;
+    }
 
-static void activate_automouse_layer() {
-    automouse_triggered = true;
-    zmk_keymap_layer_activate(AUTOMOUSE_LAYER);
-    k_timer_start(&automouse_layer_timer, K_MSEC(CONFIG_PMW3610_AUTOMOUSE_TIMEOUT_MS), K_NO_WAIT);
-}
+    if (bus_held_by_burst(dev)) {
+        pmw3610_schedule_work(&data->config_work, K_USEC(T_BUS_RETRY_US));
+        return;
+    }
 
-static void deactivate_automouse_layer(struct k_timer *timer) {
-    automouse_triggered = false;
-    zmk_keymap_layer_deactivate(AUTOMOUSE_LAYER);
-}
+    // only what changed is queued: a layer switch writes the cpi alone
+    uint32_t cpi = cpi_for_mode(data, data->active_layer_mode->mode);
+    bool settings_changed = atomic_clear(&data->settings_changed) != 0;
+    struct reg_write_session session;
+    int err = 0;
 
-K_TIMER_DEFINE(automouse_layer_timer, deactivate_automouse_layer, NULL);
-#endif
+    if (cpi == data->curr_cpi && !settings_changed) {
+        return;
+    }
 
-int ball_action_idx = -1;
-static enum pixart_input_mode get_input_mode_for_current_layer(const struct device *dev) {
-    const struct pixart_config *config = dev->config;
-    uint8_t curr_layer = zmk_keymap_highest_layer_active();
-    ball_action_idx = -1;
-    for (size_t i = 0; i < config->scroll_layers_len; i++) {
-        if (curr_layer == config->scroll_layers[i]) {
-            return SCROLL;
-        }
+    session_open(&session, dev);
+    if (cpi != data->curr_cpi) {
+        err = queue_cpi(&session, cpi);
     }
-    for (size_t i = 0; i < config->snipe_layers_len; i++) {
-        if (curr_layer == config->snipe_layers[i]) {
-            return SNIPE;
-        }
+    if (!err && settings_changed) {
+        err = queue_settings(&session);
     }
-    for (size_t i = 0; i < config->ball_actions_len; i++) {
-        for (size_t j = 0; j < config->ball_actions[i]->layers_len; j++) {
-            if (curr_layer == config->ball_actions[i]->layers[j]) {
-                ball_action_idx = i;
-                return BALL_ACTION;
-            }
+    if (!err) {
+        err = session_commit(dev, &session);
+    }
+    if (err) {
+        // the settings are queued again by the next attempt, the cpi still differs
+        if (settings_changed) {
+            atomic_set(&data->settings_changed, 1);
         }
+        data->config_retry_ms = CLAMP(data->config_retry_ms * 2, PMW3610_CONFIG_RETRY_MIN_MS,
+                                      PMW3610_CONFIG_RETRY_MAX_MS);
+        LOG_ERR("Failed to apply the settings (%d), retrying in %u ms", err,
+                data->config_retry_ms);
+        pmw3610_schedule_work(&data->config_work, K_MSEC(data->config_retry_ms));
+        return;
+    }
+
+    data->config_retry_ms = 0;
+    if (cpi != data->curr_cpi) {
+        data->curr_cpi = cpi;
+        PMW3610_STATS_INC(data, cpi_switches);
+    }
+}
+
+/* Point the active input mode at the entry of the highest active layer */
+static void update_layer_mode(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    uint8_t layer = zmk_keymap_highest_layer_active();
+
+    if (layer >= ZMK_KEYMAP_LAYERS_LEN) {
+        layer = 0;
+    }
+
+    // a single pointer store, so the motion path never sees a torn entry
+    data->active_layer_mode = &data->layer_modes[layer];
+
+    if (data->ready && cpi_for_mode(data, data->active_layer_mode->mode) != data->curr_cpi) {
+        pmw3610_schedule_work(&data->config_work, K_NO_WAIT);
     }
-    return MOVE;
 }
 
 static inline void calculate_scroll_acceleration(int16_t x, int16_t y, struct pixart_data *data,
-                                                int32_t *accel_x, int32_t *accel_y) {
+                                                uint64_t frame_cyc, int32_t *accel_x,
+                                                int32_t *accel_y) {
     *accel_x = x;
     *accel_y = y;
 
     #ifdef CONFIG_PMW3610_SCROLL_ACCELERATION
-        int32_t movement = abs(x) + abs(y);
-        int64_t current_time = k_uptime_get();
-        int64_t delta_time = data->last_scroll_time > 0 ? 
-                            current_time - data->last_scroll_time : 0;
-
-        if (delta_time > 0 && delta_time < 100) {
-            float speed = (float)movement / delta_time;
-            float base_sensitivity = (float)CONFIG_PMW3610_SCROLL_ACCELERATION_SENSITIVITY;
-            float acceleration = 1.0f + (base_sensitivity - 1.0f) * (1.0f / (1.0f + expf(-0.2f * (speed - 10.0f))));
-
-            *accel_x = (int32_t)(x * acceleration);
-            *accel_y = (int32_t)(y * acceleration);
-
-            if (abs(x) <= 1) *accel_x = x;
-            if (abs(y) <= 1) *accel_y = y;
+        uint32_t movement = abs(x) + abs(y);
+        uint32_t delta_us = data->last_scroll_valid ?
+                            frame_interval_us(data->last_scroll_cyc, frame_cyc) : 0;
+
+        // the interval between the two frames, not between their processing
+        if (delta_us > 0 && delta_us < 100 * USEC_PER_MSEC) {
+            *accel_x = pmw3610_scroll_accel(x, movement, delta_us);
+            *accel_y = pmw3610_scroll_accel(y, movement, delta_us);
         }
 
-        data->last_scroll_time = current_time;
+        data->last_scroll_cyc = frame_cyc;
+        data->last_scroll_valid = true;
     #endif
 }
 
-static inline void calculate_scroll_snap(int32_t *x, int32_t *y, struct pixart_data *data) {
+static inline void calculate_scroll_snap(int32_t *x, int32_t *y, struct pixart_data *data,
+                                         uint64_t frame_cyc) {
 #ifdef CONFIG_PMW3610_SCROLL_SNAP
     if (!x || !y || !data) {
         return;
     }
 
-    int64_t current_time = k_uptime_get();
-
     // 動きがあった場合は時間を更新
     if (*x != 0 || *y != 0) {
-        data->scroll_snap_last_time = current_time;
+        data->scroll_snap_last_cyc = frame_cyc;
+        data->scroll_snap_last_valid = true;
     }
 
 #ifdef CONFIG_PMW3610_SCROLL_SNAP_MODE_AXIS_LOCK
     // デッドタイムのチェック
     if (data->scroll_snap_in_deadtime) {
-        int64_t deadtime_elapsed = current_time - data->scroll_snap_deadtime_start;
-        if (deadtime_elapsed < CONFIG_PMW3610_SCROLL_SNAP_DEADTIME_MS) {
+        uint32_t deadtime_elapsed = frame_interval_us(data->scroll_snap_deadtime_cyc, frame_cyc);
+        if (deadtime_elapsed < CONFIG_PMW3610_SCROLL_SNAP_DEADTIME_MS * USEC_PER_MSEC) {
             // デッドタイム中は入力を無効化
             *x = 0;
             *y = 0;
@@ -673,16 +1352,16 @@ static inline void calculate_scroll_snap(int32_t *x, int32_t *y, struct pixart_d
     }
 
     // 動きが止まった場合のリセットとデッドタイム開始
-    if (data->scroll_snap_last_time > 0) {
-        int64_t elapsed = current_time - data->scroll_snap_last_time;
-        if (elapsed > CONFIG_PMW3610_SCROLL_SNAP_AXIS_LOCK_TIMEOUT_MS) {
+    if (data->scroll_snap_last_valid) {
+        uint32_t elapsed = frame_interval_us(data->scroll_snap_last_cyc, frame_cyc);
+        if (elapsed > CONFIG_PMW3610_SCROLL_SNAP_AXIS_LOCK_TIMEOUT_MS * USEC_PER_MSEC) {
             data->scroll_snap_accumulated_x = 0;
             data->scroll_snap_accumulated_y = 0;
-            data->scroll_snap_last_time = 0;
+            data->scroll_snap_last_valid = false;
 
             // デッドタイム開始
             data->scroll_snap_in_deadtime = true;
-            data->scroll_snap_deadtime_start = current_time;
+            data->scroll_snap_deadtime_cyc = frame_cyc;
         }
     }
 #else
@@ -731,32 +1410,85 @@ static inline void calculate_scroll_snap(int32_t *x, int32_t *y, struct pixart_d
 #endif
 }
 
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+/* Add the interval between two timestamps to the histogram of a stage */
+static inline void latency_record(struct pixart_data *data, enum pixart_latency_stage stage,
+                                  uint64_t start_cyc, uint64_t end_cyc) {
+    uint32_t us = frame_interval_us(start_cyc, end_cyc);
+
+    data->latency.hist[stage][MIN(find_msb_set(us), PIXART_LATENCY_BUCKETS - 1)]++;
+}
+#endif
+
+/* Report a relative input event, counting it in the statistics */
+static inline int report_rel(const struct device *dev, uint16_t code, int32_t value, bool sync,
+                             k_timeout_t timeout) {
+    struct pixart_data *data = dev->data;
+
+    int err = input_report_rel(dev, code, value, sync, timeout);
+    if (err) {
+        // the input queue is full, the caller carries the motion over
+        PMW3610_STATS_INC(data, report_backpressure);
+    } else {
+        PMW3610_STATS_INC(data, input_reports);
+    }
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    // the synced event ends the report of a burst, however many frames it was delayed by
+    if (!err && sync && data->latency.report_pending) {
+        latency_record(data, LATENCY_BURST_TO_REPORT, data->latency.burst_cyc,
+                       frame_timestamp());
+        data->latency.report_pending = false;
+    }
+#endif
+
+    return err;
+}
+
 static inline void process_scroll_events(const struct device *dev, struct pixart_data *data,
-                                        int32_t delta, bool is_horizontal) {
+                                        int32_t delta, bool is_horizontal, uint64_t frame_cyc) {
     if (abs(delta) > CONFIG_PMW3610_SCROLL_TICK) {
         int event_count = abs(delta) / CONFIG_PMW3610_SCROLL_TICK;
-        const int MAX_EVENTS = 20;
         int32_t *target_delta = is_horizontal ? &data->scroll_delta_x : &data->scroll_delta_y;
+        uint16_t code = is_horizontal ? INPUT_REL_HWHEEL : INPUT_REL_WHEEL;
+        int32_t direction = delta > 0 ?
+            (is_horizontal ? PMW3610_SCROLL_X_NEGATIVE : PMW3610_SCROLL_Y_NEGATIVE) :
+            (is_horizontal ? PMW3610_SCROLL_X_POSITIVE : PMW3610_SCROLL_Y_POSITIVE);
+
+#ifdef CONFIG_PMW3610_SCROLL_REPORT_PER_TICK
+        const int MAX_EVENTS = 20;
 
         if (event_count > MAX_EVENTS) {
+            PMW3610_STATS_ADD(data, scroll_ticks_truncated, event_count - MAX_EVENTS);
             event_count = MAX_EVENTS;
             *target_delta = (delta > 0) ? 
                 delta - (MAX_EVENTS * CONFIG_PMW3610_SCROLL_TICK) :
                 delta + (MAX_EVENTS * CONFIG_PMW3610_SCROLL_TICK);
-            data->last_remainder_time = k_uptime_get();
+            data->last_remainder_cyc = frame_cyc;
+            data->last_remainder_valid = true;
         } else {
             *target_delta = delta % CONFIG_PMW3610_SCROLL_TICK;
         }
 
         for (int i = 0; i < event_count; i++) {
-            input_report_rel(dev,
-                            is_horizontal ? INPUT_REL_HWHEEL : INPUT_REL_WHEEL,
-                            delta > 0 ? 
-                                (is_horizontal ? PMW3610_SCROLL_X_NEGATIVE : PMW3610_SCROLL_Y_NEGATIVE) :
-                                (is_horizontal ? PMW3610_SCROLL_X_POSITIVE : PMW3610_SCROLL_Y_POSITIVE),
-                            (i == event_count - 1),
-                            K_MSEC(10));
+            if (report_rel(dev, code, direction, (i == event_count - 1),
+                           PMW3610_SCROLL_REPORT_TIMEOUT)) {
+                // keep the ticks which were not reported for the next frame
+                *target_delta += (delta > 0 ? 1 : -1) * (event_count - i) *
+                                 CONFIG_PMW3610_SCROLL_TICK;
+                break;
+            }
+            PMW3610_STATS_INC(data, scroll_ticks);
+        }
+#else
+        // all the ticks in a single event, in high-resolution units when the deltas are scaled
+        *target_delta = delta % CONFIG_PMW3610_SCROLL_TICK;
+        if (report_rel(dev, code, direction * event_count, true, PMW3610_SCROLL_REPORT_TIMEOUT)) {
+            *target_delta = delta;
+        } else {
+            PMW3610_STATS_ADD(data, scroll_ticks, event_count);
         }
+#endif
 
         // 軸固定モードでは、この処理をスキップする
         // 軸固定モードでは既にcalculate_scroll_snapで非主軸の動きをゼロにしているため
@@ -771,50 +1503,231 @@ static inline void process_scroll_events(const struct device *dev, struct pixart
     }
 }
 
+/* Report the accumulated pointer motion, if any. An axis is only reported when it moved, the last
+ * one carrying the sync event. */
+static void flush_pointer(const struct device *dev) {
+    struct pixart_data *data = dev->data;
+    bool x_sent = false;
+    int err = 0;
+
+    if (data->report_y_unsynced) {
+        // the input subsystem holds the x of the last report, y alone completes it
+        err = report_rel(dev, INPUT_REL_Y, data->report_y, true, PMW3610_POINTER_REPORT_TIMEOUT);
+        if (!err) {
+            data->report_y = 0;
+            data->report_y_unsynced = false;
+        }
+    } else if (data->report_x != 0 || data->report_y != 0) {
+        if (data->report_x != 0) {
+            err = report_rel(dev, INPUT_REL_X, data->report_x, data->report_y == 0,
+                             PMW3610_POINTER_REPORT_TIMEOUT);
+            if (!err) {
+                data->report_x = 0;
+                x_sent = true;
+            }
+        }
+        if (!err && data->report_y != 0) {
+            err = report_rel(dev, INPUT_REL_Y, data->report_y, true,
+                             PMW3610_POINTER_REPORT_TIMEOUT);
+            if (!err) {
+                data->report_y = 0;
+            } else {
+                data->report_y_unsynced = x_sent;
+            }
+        }
+    } else {
+        return;
+    }
+
+    if (!err || x_sent) {
+        data->last_report_cyc = data->report_frame_cyc;
+        data->last_report_valid = true;
+    }
+
+#ifdef CONFIG_PMW3610_REPORT_NO_WAIT
+    // an axis which could not be reported is kept, and retried shortly even if no other motion
+    // comes
+    if (data->report_x != 0 || data->report_y != 0 || data->report_y_unsynced) {
+        pmw3610_schedule_work(&data->flush_work, K_MSEC(1));
+    }
+#endif
+}
+
+static void pmw3610_flush_work_callback(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *data = CONTAINER_OF(dwork, struct pixart_data, flush_work);
+
+    flush_pointer(data->dev);
+}
 
-static int pmw3610_report_data(const struct device *dev) {
+/* Report pointer motion, at most once per CONFIG_PMW3610_REPORT_INTERVAL_MS. Motion arriving
+ * within the interval is added up and flushed at its end, so the first motion after a pause is
+ * reported right away and none is dropped. The flush work runs on the queue of the motion path,
+ * so the accumulators need no lock. */
+static void report_pointer(const struct device *dev, int16_t x, int16_t y, uint64_t frame_cyc) {
     struct pixart_data *data = dev->data;
-    uint8_t buf[PMW3610_BURST_SIZE];
 
-    if (unlikely(!data->ready)) {
-        LOG_WRN("Device is not initialized yet");
-        return -EBUSY;
+    data->report_x += x;
+    data->report_y += y;
+    data->report_frame_cyc = frame_cyc;
+
+#if CONFIG_PMW3610_REPORT_INTERVAL_MS > 0
+    if (k_work_delayable_is_pending(&data->flush_work)) {
+        return;
+    }
+
+    // the interval is measured between the frames, so that queueing jitter does not shift it
+    uint32_t elapsed_us = frame_interval_us(data->last_report_cyc, frame_cyc);
+    if (data->last_report_valid &&
+        elapsed_us < CONFIG_PMW3610_REPORT_INTERVAL_MS * USEC_PER_MSEC) {
+        pmw3610_schedule_work(&data->flush_work,
+                              K_USEC(CONFIG_PMW3610_REPORT_INTERVAL_MS * USEC_PER_MSEC -
+                                     elapsed_us));
+        return;
+    }
+#endif
+
+    flush_pointer(dev);
+}
+
+#ifdef CONFIG_PMW3610_ADJUSTABLE_MOUSESPEED
+// default pointer curve, the historical step table: x0.1 at 2 counts/frame up to x1.0 at 6, x1.5
+// past 30 and x3.0 past 60. Speeds are integers, so the one-count ramps reproduce the steps.
+static const int32_t legacy_accel_points[] = {
+    1, 1000, 2, 100, 3, 500, 4, 700, 5, 900, 6, 1000, 30, 1000, 31, 1500, 60, 1500, 61, 3000,
+};
+
+static const struct pixart_accel_curve legacy_accel_curve = {
+    .points = legacy_accel_points,
+    .len = ARRAY_SIZE(legacy_accel_points) / 2,
+};
+#endif
+
+/* Acceleration curve of an input mode, NULL when the motion is not accelerated */
+static const struct pixart_accel_curve *accel_curve_for_mode(const struct device *dev,
+                                                             enum pixart_input_mode mode) {
+    const struct pixart_config *config = dev->config;
+
+    if (mode == SNIPE && config->snipe_accel_curve.len > 0) {
+        return &config->snipe_accel_curve;
+    }
+
+    if (mode != MOVE && mode != SNIPE) {
+        return NULL;
+    }
+
+    if (config->accel_curve.len > 0) {
+        return &config->accel_curve;
+    }
+
+#ifdef CONFIG_PMW3610_ADJUSTABLE_MOUSESPEED
+    return &legacy_accel_curve;
+#else
+    return NULL;
+#endif
+}
+
+/* Multiplier of a curve at a speed, in permille */
+static int32_t accel_curve_multiplier(const struct pixart_accel_curve *curve, int32_t speed) {
+    const int32_t *p = curve->points;
+
+    if (speed <= p[0]) {
+        return p[1];
+    }
+
+    for (size_t i = 1; i < curve->len; i++) {
+        int32_t s0 = p[2 * i - 2], m0 = p[2 * i - 1];
+        int32_t s1 = p[2 * i], m1 = p[2 * i + 1];
+
+        // speed > s0 here, so s1 > s0 whenever this segment is taken
+        if (speed <= s1) {
+            return m0 + (m1 - m0) * (speed - s0) / (s1 - s0);
+        }
+    }
+
+    return p[2 * curve->len - 1];
+}
+
+/* Scale a motion count by num / den, carrying the remainder so slow motion is not lost */
+static inline int16_t scale_motion(int32_t value, int32_t num, int32_t den, int32_t *rem) {
+    if (num == den || den <= 0) {
+        return value;
+    }
+
+    int32_t scaled = value * num + *rem;
+
+    *rem = scaled % den;
+    return scaled / den;
+}
+
+/* Scale a motion by a curve, carrying the sub-count remainder to the next frame */
+static void apply_accel_curve(struct pixart_data *data, const struct pixart_accel_curve *curve,
+                              int16_t *x, int16_t *y) {
+    if (curve == NULL) {
+        return;
     }
 
-    int32_t dividor;
-    enum pixart_input_mode input_mode = get_input_mode_for_current_layer(dev);
+    int32_t mult = accel_curve_multiplier(curve, abs(*x) + abs(*y));
+    int32_t scaled_x = *x * mult + data->accel_rem_x;
+    int32_t scaled_y = *y * mult + data->accel_rem_y;
+
+    data->accel_rem_x = scaled_x % PIXART_ACCEL_ONE;
+    data->accel_rem_y = scaled_y % PIXART_ACCEL_ONE;
+    *x = CLAMP(scaled_x / PIXART_ACCEL_ONE, INT16_MIN, INT16_MAX);
+    *y = CLAMP(scaled_y / PIXART_ACCEL_ONE, INT16_MIN, INT16_MAX);
+}
+
+/* Process a motion frame, frame_cyc being its timestamp (see pixart_data.frame_cyc) */
+static int pmw3610_report_data(const struct device *dev, const uint8_t *buf, uint64_t frame_cyc) {
+    struct pixart_data *data = dev->data;
+
+    // the motion is scaled by scale_num / scale_den
+    int32_t scale_num = 1, scale_den = 1;
+    const struct pixart_layer_mode *layer_mode = data->active_layer_mode;
+    enum pixart_input_mode input_mode = layer_mode->mode;
     bool input_mode_changed = data->curr_mode != input_mode;
     switch (input_mode) {
     case MOVE:
-        set_cpi_if_needed(dev, CONFIG_PMW3610_CPI);
-        dividor = CONFIG_PMW3610_CPI_DIVIDOR;
+        if (input_mode_changed) {
+            data->accel_rem_x = 0;
+            data->accel_rem_y = 0;
+        }
+#if CONFIG_PMW3610_EFFECTIVE_CPI > 0
+        scale_num = CONFIG_PMW3610_EFFECTIVE_CPI;
+        scale_den = data->curr_cpi;
+#else
+        scale_den = CONFIG_PMW3610_CPI_DIVIDOR;
+#endif
         break;
     case SCROLL:
-        set_cpi_if_needed(dev, CONFIG_PMW3610_CPI);
         if (input_mode_changed) {
             data->scroll_delta_x = 0;
             data->scroll_delta_y = 0;
 #ifdef CONFIG_PMW3610_SCROLL_SNAP
             data->scroll_snap_accumulated_x = 0;
             data->scroll_snap_accumulated_y = 0;
-            data->scroll_snap_last_time = 0;
-            data->scroll_snap_deadtime_start = 0;
+            data->scroll_snap_last_valid = false;
             data->scroll_snap_in_deadtime = false;
 #endif            
         }
-        dividor = 1;
         break;
     case SNIPE:
-        set_cpi_if_needed(dev, CONFIG_PMW3610_SNIPE_CPI);
-        dividor = CONFIG_PMW3610_SNIPE_CPI_DIVIDOR;
+        if (input_mode_changed) {
+            data->accel_rem_x = 0;
+            data->accel_rem_y = 0;
+        }
+#if CONFIG_PMW3610_SNIPE_EFFECTIVE_CPI > 0
+        scale_num = CONFIG_PMW3610_SNIPE_EFFECTIVE_CPI;
+        scale_den = data->curr_cpi;
+#else
+        scale_den = CONFIG_PMW3610_SNIPE_CPI_DIVIDOR;
+#endif
         break;
     case BALL_ACTION:
-        set_cpi_if_needed(dev, CONFIG_PMW3610_CPI);
         if (input_mode_changed) {
             data->ball_action_delta_x = 0;
             data->ball_action_delta_y = 0;
         }
-        dividor = 1;
         break;
     default:
         return -ENOTSUP;
@@ -822,52 +1735,26 @@ static int pmw3610_report_data(const struct device *dev) {
 
     data->curr_mode = input_mode;
 
+    if (buf[PMW3610_X_L_POS] == 0 && buf[PMW3610_Y_L_POS] == 0 && buf[PMW3610_XY_H_POS] == 0) {
+        PMW3610_STATS_INC(data, zero_delta_frames);
+    }
+
     int16_t x = 0;
     int16_t y = 0;
 
-#if AUTOMOUSE_LAYER > 0
-    if (input_mode == MOVE &&
-        (automouse_triggered || zmk_keymap_highest_layer_active() != AUTOMOUSE_LAYER) &&
-        (abs(x) + abs(y) > CONFIG_PMW3610_MOVEMENT_THRESHOLD)
-    ) {
-        activate_automouse_layer();
-    }
-#endif
-
-    int err = motion_burst_read(dev, buf, sizeof(buf));
-    if (err) {
-        return err;
+    if (input_mode_changed) {
+        data->scale_rem_x = 0;
+        data->scale_rem_y = 0;
     }
 
-    int16_t raw_x =
-        TOINT16((buf[PMW3610_X_L_POS] + ((buf[PMW3610_XY_H_POS] & 0xF0) << 4)), 12) / dividor;
-    int16_t raw_y =
-        TOINT16((buf[PMW3610_Y_L_POS] + ((buf[PMW3610_XY_H_POS] & 0x0F) << 8)), 12) / dividor;
-
-#ifdef CONFIG_PMW3610_ADJUSTABLE_MOUSESPEED
-    int16_t movement_size = abs(raw_x) + abs(raw_y);
-
-    float speed_multiplier = 1.0; //速度の倍率
-    if (movement_size > 60) {
-        speed_multiplier = 3.0;
-    }else if (movement_size > 30) {
-        speed_multiplier = 1.5;
-    }else if (movement_size > 5) {
-        speed_multiplier = 1.0;
-    }else if (movement_size > 4) {
-        speed_multiplier = 0.9;
-    }else if (movement_size > 3) {
-        speed_multiplier = 0.7;
-    }else if (movement_size > 2) {
-        speed_multiplier = 0.5;
-    }else if (movement_size > 1) {
-        speed_multiplier = 0.1;
-    }
-
-    raw_x = raw_x * speed_multiplier;
-    raw_y = raw_y * speed_multiplier;
+    int16_t raw_x = scale_motion(
+        TOINT16((buf[PMW3610_X_L_POS] + ((buf[PMW3610_XY_H_POS] & 0xF0) << 4)), 12), scale_num,
+        scale_den, &data->scale_rem_x);
+    int16_t raw_y = scale_motion(
+        TOINT16((buf[PMW3610_Y_L_POS] + ((buf[PMW3610_XY_H_POS] & 0x0F) << 8)), 12), scale_num,
+        scale_den, &data->scale_rem_y);
 
-#endif
+    apply_accel_curve(data, accel_curve_for_mode(dev, input_mode), &raw_x, &raw_y);
 
     if (IS_ENABLED(CONFIG_PMW3610_ORIENTATION_0)) {
         x = -raw_x;
@@ -891,13 +1778,12 @@ static int pmw3610_report_data(const struct device *dev) {
         y = -y;
     }
 
- int64_t current_time = k_uptime_get();
-    if (data->last_remainder_time > 0) {
-        int64_t elapsed = current_time - data->last_remainder_time;
-        if (elapsed > 100) {
+    if (data->last_remainder_valid) {
+        uint32_t elapsed = frame_interval_us(data->last_remainder_cyc, frame_cyc);
+        if (elapsed > 100 * USEC_PER_MSEC) {
             data->scroll_delta_x = 0;
             data->scroll_delta_y = 0;
-            data->last_remainder_time = 0;
+            data->last_remainder_valid = false;
         } 
     }
     
@@ -905,127 +1791,302 @@ static int pmw3610_report_data(const struct device *dev) {
     int16_t shutter =
         ((int16_t)(buf[PMW3610_SHUTTER_H_POS] & 0x01) << 8) + buf[PMW3610_SHUTTER_L_POS];
     if (data->sw_smart_flag && shutter < 45) {
-        reg_write(dev, 0x32, 0x00);
+        reg_write(dev, PMW3610_REG_SMART_MODE, 0x00);
 
         data->sw_smart_flag = false;
+        PMW3610_STATS_INC(data, smart_toggles);
     }
 
     if (!data->sw_smart_flag && shutter > 45) {
-        reg_write(dev, 0x32, 0x80);
+        reg_write(dev, PMW3610_REG_SMART_MODE, 0x80);
 
         data->sw_smart_flag = true;
-    }
-#endif
-
-#ifdef CONFIG_PMW3610_POLLING_RATE_125_SW
-    int64_t curr_time = k_uptime_get();
-    if (data->last_poll_time == 0 || curr_time - data->last_poll_time > 128) {
-        data->last_poll_time = curr_time;
-        data->last_x = x;
-        data->last_y = y;
-        return 0;
-    } else {
-        x += data->last_x;
-        y += data->last_y;
-        data->last_poll_time = 0;
-        data->last_x = 0;
-        data->last_y = 0;
+        PMW3610_STATS_INC(data, smart_toggles);
     }
 #endif
 
     if (x != 0 || y != 0) {
         if (input_mode == MOVE || input_mode == SNIPE) {
-#if AUTOMOUSE_LAYER > 0
-            // トラックボールの動きの大きさを計算
-            int16_t movement_size = abs(x) + abs(y);
-            if (input_mode == MOVE &&
-                (automouse_triggered || zmk_keymap_highest_layer_active() != AUTOMOUSE_LAYER) &&
-                movement_size > CONFIG_PMW3610_MOVEMENT_THRESHOLD) {
-                activate_automouse_layer();
+            if (input_mode == MOVE) {
+                trigger_automouse_layer(dev, x, y);
             }
-#endif
-            input_report_rel(dev, INPUT_REL_X, x, false, K_FOREVER);
-            input_report_rel(dev, INPUT_REL_Y, y, true, K_FOREVER);
+            report_pointer(dev, x, y, frame_cyc);
         } else if (input_mode == SCROLL) {
             // まずスクロールスナップ処理を適用
             int32_t snap_x = x, snap_y = y;
-            calculate_scroll_snap(&snap_x, &snap_y, data);
+            calculate_scroll_snap(&snap_x, &snap_y, data, frame_cyc);
 
             // 次にスクロール加速処理を適用
             int32_t accel_x, accel_y;
-            calculate_scroll_acceleration(snap_x, snap_y, data, &accel_x, &accel_y);
+            calculate_scroll_acceleration(snap_x, snap_y, data, frame_cyc, &accel_x, &accel_y);
 
-            data->scroll_delta_x += accel_x;
-            data->scroll_delta_y += accel_y;
+            data->scroll_delta_x += accel_x * PMW3610_SCROLL_DELTA_SCALE;
+            data->scroll_delta_y += accel_y * PMW3610_SCROLL_DELTA_SCALE;
 
-            process_scroll_events(dev, data, data->scroll_delta_y, false);
-            process_scroll_events(dev, data, data->scroll_delta_x, true);
+            process_scroll_events(dev, data, data->scroll_delta_y, false, frame_cyc);
+            process_scroll_events(dev, data, data->scroll_delta_x, true, frame_cyc);
         } else if (input_mode == BALL_ACTION) {
             data->ball_action_delta_x += x;
             data->ball_action_delta_y += y;
 
             const struct pixart_config *config = dev->config;
 
-            if(ball_action_idx != -1) {
-                const struct ball_action_cfg action_cfg = *config->ball_actions[ball_action_idx];
+            if(layer_mode->ball_action != -1) {
+                const struct ball_action_cfg action_cfg = *config->ball_actions[layer_mode->ball_action];
+
+                struct zmk_behavior_binding_event event = {
+                    .position = INT32_MAX,
+                    .timestamp = k_uptime_get(),
+#if IS_ENABLED(CONFIG_ZMK_SPLIT)
+                    .source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
+#endif
+
+                };
+
+                // determine which binding to invoke
+                int idx = -1;
+                if(abs(data->ball_action_delta_x) > action_cfg.tick) {
+                    idx = data->ball_action_delta_x > 0 ? 0 : 1;
+                } else if(abs(data->ball_action_delta_y) > action_cfg.tick) {
+                    idx = data->ball_action_delta_y > 0 ? 3 : 2;
+                }
+
+                if(idx != -1) {
+                    zmk_behavior_queue_add(&event, action_cfg.bindings[idx], true, action_cfg.tap_ms);
+                    zmk_behavior_queue_add(&event, action_cfg.bindings[idx], false, action_cfg.wait_ms);
+                    PMW3610_STATS_INC(data, ball_actions);
+
+                    data->ball_action_delta_x = 0;
+                    data->ball_action_delta_y = 0;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* Process a motion burst, timing the processing for the statistics */
+static void pmw3610_handle_burst(const struct device *dev, const uint8_t *buf, uint64_t frame_cyc) {
+#ifdef CONFIG_PMW3610_STATS
+    struct pixart_data *data = dev->data;
+    uint32_t start = k_cycle_get_32();
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    uint64_t burst_cyc = frame_timestamp();
+    latency_record(data, LATENCY_WORK_TO_BURST, data->latency.work_cyc, burst_cyc);
+    data->latency.burst_cyc = burst_cyc;
+    data->latency.report_pending = true;
+#endif
+
+    pmw3610_report_data(dev, buf, frame_cyc);
+
+    uint32_t end = k_cycle_get_32();
+    data->stats.report_cycles += end - start;
+    data->stats.reports++;
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    // a drained burst is read right after this one
+    data->latency.work_cyc = frame_timestamp();
+#endif
+#else
+    pmw3610_report_data(dev, buf, frame_cyc);
+#endif
+}
+
+static void pmw3610_gpio_callback(const struct device *gpiob, struct gpio_callback *cb,
+                                  uint32_t pins) {
+    struct pixart_data *data = CONTAINER_OF(cb, struct pixart_data, irq_gpio_cb);
+    const struct device *dev = data->dev;
+
+    set_interrupt(dev, false);
+
+    data->frame_cyc = frame_timestamp();
+    PMW3610_STATS_INC(data, motion_irqs);
+
+    // submit the real handler work
+    pmw3610_submit_work(&data->trigger_work);
+}
+
+#ifdef CONFIG_PMW3610_STATS
+// track how long the motion work waited in its queue after the interrupt
+static void pmw3610_stats_queue_delay(struct pixart_data *data) {
+    uint64_t now = frame_timestamp();
+    uint32_t delay_us = frame_interval_us(data->frame_cyc, now);
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    latency_record(data, LATENCY_IRQ_TO_WORK, data->frame_cyc, now);
+    data->latency.work_cyc = now;
+#endif
+
+    if (delay_us > data->stats.max_queue_delay_us) {
+        data->stats.max_queue_delay_us = delay_us;
+        LOG_DBG("Max queueing delay %u us", delay_us);
+    }
+}
+#endif
+
+#ifdef CONFIG_PMW3610_MOTION_DRAIN
+/* Whether to read the next burst right away instead of re-arming the interrupt, which is the case
+ * while the ball keeps moving: the last burst had motion and the motion line is asserted again. */
+static bool motion_drain_next(const struct device *dev, const uint8_t *buf) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+
+    if (!(buf[PMW3610_MOTION_POS] & PMW3610_MOTION_MOT) ||
+        ++data->drain_count >= CONFIG_PMW3610_MOTION_DRAIN_BUDGET ||
+        gpio_pin_get_dt(&config->irq_gpio) <= 0) {
+        data->drain_count = 0;
+        return false;
+    }
+
+    // a drained burst has no interrupt, it is timestamped as it is read
+    data->frame_cyc = frame_timestamp();
+    PMW3610_STATS_INC(data, drained_bursts);
+    return true;
+}
+#endif
+
+static void pmw3610_work_callback(struct k_work *work) {
+    struct pixart_data *data = CONTAINER_OF(work, struct pixart_data, trigger_work);
+    const struct device *dev = data->dev;
+
+    if (unlikely(!data->ready)) {
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+        // a burst which completed while the sensor was being shut down is dropped
+        data->burst_state = BURST_IDLE;
+#endif
+        LOG_WRN("Device is not initialized yet");
+        set_interrupt(dev, true);
+        return;
+    }
+
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+    if (data->burst_state != BURST_DATA_DONE) {
+#ifdef CONFIG_PMW3610_STATS
+        if (data->burst_state == BURST_IDLE) {
+            pmw3610_stats_queue_delay(data);
+        }
+#endif
+
+        // start the next phase of the burst, this work is resubmitted on its completion
+        if (motion_burst_async_step(dev) != 0) {
+            set_interrupt(dev, true);
+        }
+        return;
+    }
+
+    data->burst_state = BURST_IDLE;
+    if (data->burst_err == 0) {
+        pmw3610_handle_burst(dev, data->burst_buf, data->frame_cyc);
+
+#ifdef CONFIG_PMW3610_MOTION_DRAIN
+        if (motion_drain_next(dev, data->burst_buf) && motion_burst_async_step(dev) == 0) {
+            return;
+        }
+#endif
+    }
+#else
+#ifdef CONFIG_PMW3610_STATS
+    pmw3610_stats_queue_delay(data);
+#endif
+
+    uint8_t buf[PMW3610_BURST_SIZE];
+    bool read_next;
+    do {
+        read_next = false;
+        if (motion_burst_read(dev, buf, sizeof(buf)) == 0) {
+            pmw3610_handle_burst(dev, buf, data->frame_cyc);
+#ifdef CONFIG_PMW3610_MOTION_DRAIN
+            read_next = motion_drain_next(dev, buf);
+#endif
+        }
+    } while (read_next);
+#endif
+
+    set_interrupt(dev, true);
+}
 
-                struct zmk_behavior_binding_event event = {
-                    .position = INT32_MAX,
-                    .timestamp = k_uptime_get(),
-#if IS_ENABLED(CONFIG_ZMK_SPLIT)
-                    .source = ZMK_POSITION_STATE_CHANGE_SOURCE_LOCAL,
-#endif
+/* Read the motion registers one by one, into the layout of a motion burst. Reading the motion
+ * register latches the delta registers, which a burst read would latch again (and lose). */
+static int motion_poll_read(const struct device *dev, uint8_t *buf) {
+    int err;
 
-                };
+    bus_lock(dev);
 
-                // determine which binding to invoke
-                int idx = -1;
-                if(abs(data->ball_action_delta_x) > action_cfg.tick) {
-                    idx = data->ball_action_delta_x > 0 ? 0 : 1;
-                } else if(abs(data->ball_action_delta_y) > action_cfg.tick) {
-                    idx = data->ball_action_delta_y > 0 ? 3 : 2;
-                }
+    err = _reg_read(dev, PMW3610_REG_MOTION, &buf[PMW3610_MOTION_POS]);
+    if (err || !(buf[PMW3610_MOTION_POS] & PMW3610_MOTION_MOT)) {
+        goto out;
+    }
 
-                if(idx != -1) {
-                    zmk_behavior_queue_add(&event, action_cfg.bindings[idx], true, action_cfg.tap_ms);
-                    zmk_behavior_queue_add(&event, action_cfg.bindings[idx], false, action_cfg.wait_ms);
+    err = _reg_read(dev, PMW3610_REG_DELTA_X_L, &buf[PMW3610_X_L_POS]);
+    if (!err) {
+        err = _reg_read(dev, PMW3610_REG_DELTA_Y_L, &buf[PMW3610_Y_L_POS]);
+    }
+    if (!err) {
+        err = _reg_read(dev, PMW3610_REG_DELTA_XY_H, &buf[PMW3610_XY_H_POS]);
+    }
+#ifdef CONFIG_PMW3610_SMART_ALGORITHM
+    if (!err) {
+        err = _reg_read(dev, PMW3610_REG_SHUTTER_HIGHER, &buf[PMW3610_SHUTTER_H_POS]);
+    }
+    if (!err) {
+        err = _reg_read(dev, PMW3610_REG_SHUTTER_LOWER, &buf[PMW3610_SHUTTER_L_POS]);
+    }
+#endif
 
-                    data->ball_action_delta_x = 0;
-                    data->ball_action_delta_y = 0;
-                }
-            }
-        }
+out:
+    bus_unlock(dev);
+    if (err) {
+        LOG_ERR("Motion poll read failed: %d", err);
     }
 
     return err;
 }
 
-static void pmw3610_gpio_callback(const struct device *gpiob, struct gpio_callback *cb,
-                                  uint32_t pins) {
-    struct pixart_data *data = CONTAINER_OF(cb, struct pixart_data, irq_gpio_cb);
+/* Poll the motion register in place of the motion irq. The interval stays at its minimum while
+ * moving, and doubles on every idle poll once the run downshift time has elapsed, like the
+ * sensor itself moves to its rest modes. */
+static void pmw3610_poll_work_callback(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *data = CONTAINER_OF(dwork, struct pixart_data, poll_work);
     const struct device *dev = data->dev;
+    uint8_t buf[PMW3610_BURST_SIZE] = {0};
+    int64_t now = k_uptime_get();
+
+    // no interrupt, the frame is timestamped by the poll
+    data->frame_cyc = frame_timestamp();
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    // the poll read stands for the burst read
+    data->latency.work_cyc = data->frame_cyc;
+#endif
 
-    set_interrupt(dev, false);
-
-    // submit the real handler work
-    k_work_submit(&data->trigger_work);
-}
+    if (motion_poll_read(dev, buf) == 0 && (buf[PMW3610_MOTION_POS] & PMW3610_MOTION_MOT)) {
+        pmw3610_handle_burst(dev, buf, data->frame_cyc);
 
-static void pmw3610_work_callback(struct k_work *work) {
-    struct pixart_data *data = CONTAINER_OF(work, struct pixart_data, trigger_work);
-    const struct device *dev = data->dev;
+        data->poll_last_motion = now;
+        data->poll_interval_ms = CONFIG_PMW3610_POLL_INTERVAL_MIN_MS;
+    } else if (now - data->poll_last_motion > CONFIG_PMW3610_RUN_DOWNSHIFT_TIME_MS) {
+        data->poll_interval_ms =
+            MIN(data->poll_interval_ms * 2, CONFIG_PMW3610_POLL_INTERVAL_MAX_MS);
+    }
 
-    pmw3610_report_data(dev);
-    set_interrupt(dev, true);
+    pmw3610_schedule_work(&data->poll_work, K_MSEC(data->poll_interval_ms));
 }
 
 static int pmw3610_init_irq(const struct device *dev) {
-    LOG_INF("Configure irq...");
-
     int err;
     struct pixart_data *data = dev->data;
     const struct pixart_config *config = dev->config;
 
+    if (pmw3610_polling(dev)) {
+        LOG_INF("No irq line, polling motion");
+        data->poll_interval_ms = CONFIG_PMW3610_POLL_INTERVAL_MIN_MS;
+        k_work_init_delayable(&data->poll_work, pmw3610_poll_work_callback);
+        return 0;
+    }
+
+    LOG_INF("Configure irq...");
+
     // check readiness of irq gpio pin
     if (!device_is_ready(config->irq_gpio.port)) {
         LOG_ERR("IRQ GPIO device not ready");
@@ -1052,6 +2113,177 @@ static int pmw3610_init_irq(const struct device *dev) {
     return err;
 }
 
+#ifdef CONFIG_PM_DEVICE
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+// whether the caller runs on the queue of the motion path, which completes the bursts
+static inline bool pmw3610_on_work_q(void) {
+#ifdef CONFIG_PMW3610_DEDICATED_WORKQUEUE
+    return k_current_get() == k_work_queue_thread_get(&pmw3610_work_q);
+#else
+    return k_current_get() == k_work_queue_thread_get(&k_sys_work_q);
+#endif
+}
+#endif
+
+/* Shut the sensor down. Pending pointer motion is reported first, and the bus is released so that
+ * its pins can go to their sleep state. */
+static int pmw3610_power_off(const struct device *dev) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+    struct k_work_sync sync;
+    bool was_ready = data->ready;
+    int err;
+
+#ifdef CONFIG_PMW3610_ASYNC_BURST
+    // the burst holding the bus needs the very queue the caller blocks to complete
+    if (pmw3610_on_work_q() && bus_held_by_burst(dev)) {
+        return -EBUSY;
+    }
+#endif
+
+    data->suspended = true;
+    set_interrupt(dev, false);
+
+    if (data->async_init_step < ASYNC_INIT_STEP_COUNT) {
+        // not initialized yet, the init restarts from the power-up reset on wake up
+        k_work_cancel_delayable_sync(&data->init_work, &sync);
+        data->async_init_step = 0;
+    }
+
+    if (pmw3610_polling(dev)) {
+        k_work_cancel_delayable(&data->poll_work);
+    }
+#if CONFIG_PMW3610_REG_CHECK_INTERVAL_MS > 0
+    k_work_cancel_delayable(&data->reg_check_work);
+#endif
+    k_work_cancel_delayable(&data->config_work);
+
+    // a burst in flight completes before the motion path stops
+    bus_lock(dev);
+    data->ready = false;
+    bus_unlock(dev);
+
+    // motion waiting for the report interval is sent before the shutdown, not replayed on resume
+    k_work_cancel_delayable(&data->flush_work);
+    flush_pointer(dev);
+
+    err = reg_write(dev, PMW3610_REG_SHUTDOWN, PMW3610_SHUTDOWN_CMD);
+    if (err) {
+        LOG_ERR("Cannot shut the sensor down: %d", err);
+        data->suspended = false;
+        if (was_ready) {
+            pmw3610_start(dev);
+        } else {
+            data->init_step_start = k_uptime_get();
+            k_work_schedule(&data->init_work, K_MSEC(async_init_delay[data->async_init_step]));
+        }
+        return err;
+    }
+
+#ifdef CONFIG_PM_DEVICE_RUNTIME
+    pm_device_runtime_put(config->bus.bus);
+#else
+    ARG_UNUSED(config);
+#endif
+
+    LOG_INF("Suspended");
+    return 0;
+}
+
+/* Take the bus and wake the sensor up, or initialize it if it never was. Waking up only restores
+ * the configuration registers which did not survive the shutdown, without the power-up reset and
+ * the self-test of the init sequence. */
+static int pmw3610_power_on(const struct device *dev) {
+    const struct pixart_config *config = dev->config;
+    struct pixart_data *data = dev->data;
+    int err;
+
+#ifdef CONFIG_PM_DEVICE_RUNTIME
+    err = pm_device_runtime_get(config->bus.bus);
+    if (err < 0) {
+        LOG_ERR("Cannot resume the bus: %d", err);
+        return err;
+    }
+#else
+    ARG_UNUSED(config);
+#endif
+
+    data->suspended = false;
+
+    if (data->async_init_step < ASYNC_INIT_STEP_COUNT) {
+        data->init_step_start = k_uptime_get();
+        k_work_schedule(&data->init_work, K_MSEC(async_init_delay[data->async_init_step]));
+        return 0;
+    }
+
+    err = reg_write(dev, PMW3610_REG_POWER_UP_RESET, PMW3610_POWERUP_CMD_WAKEUP);
+    if (!err) {
+        k_msleep(T_WAKEUP_MS);
+        err = clear_motion_regs(dev);
+    }
+    if (!err) {
+        err = shadow_verify_restore(dev);
+    }
+    if (err < 0) {
+        LOG_ERR("Cannot resume the sensor: %d", err);
+
+        // the next resume goes through the whole init sequence, with its power-up reset
+        data->suspended = true;
+        data->async_init_step = 0;
+#ifdef CONFIG_PM_DEVICE_RUNTIME
+        pm_device_runtime_put(config->bus.bus);
+#endif
+        return err;
+    }
+
+    pmw3610_start(dev);
+    LOG_INF("Resumed");
+    return 0;
+}
+
+static int pmw3610_pm_action(const struct device *dev, enum pm_device_action action) {
+    switch (action) {
+    case PM_DEVICE_ACTION_SUSPEND:
+        return pmw3610_power_off(dev);
+    case PM_DEVICE_ACTION_RESUME:
+        return pmw3610_power_on(dev);
+    default:
+        return -ENOTSUP;
+    }
+}
+#endif
+
+#ifdef CONFIG_PMW3610_SUSPEND_ON_IDLE
+/* Release the runtime PM reference of the driver while the keyboard is idle, and take it back on
+ * the next activity. Other users of the sensor may keep it active with their own references. The
+ * reference changes, and with them the PM actions, run on the motion work queue: the wake up does
+ * not block the event manager, and no burst is in flight. */
+static void pmw3610_idle_work_callback(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct pixart_data *data = CONTAINER_OF(dwork, struct pixart_data, idle_work);
+    const struct device *dev = data->dev;
+    bool idle = data->idle_requested;
+
+    // both the IDLE and the SLEEP states are reported
+    if (idle == data->idle_released) {
+        return;
+    }
+
+    if (bus_held_by_burst(dev)) {
+        pmw3610_schedule_work(&data->idle_work, K_USEC(T_BUS_RETRY_US));
+        return;
+    }
+
+    int err = idle ? pm_device_runtime_put(dev) : pm_device_runtime_get(dev);
+    if (err < 0) {
+        LOG_ERR("Cannot change the power state: %d", err);
+        return;
+    }
+
+    data->idle_released = idle;
+}
+#endif
+
 static int pmw3610_init(const struct device *dev) {
     LOG_INF("Start initializing...");
 
@@ -1062,21 +2294,59 @@ static int pmw3610_init(const struct device *dev) {
     // init device pointer
     data->dev = dev;
 
+    // init bus lock
+    k_sem_init(&data->bus_sem, 1, 1);
+
     // init smart algorithm flag;
     data->sw_smart_flag = false;
 
+    // init the runtime settings
+    data->cpi = CONFIG_PMW3610_CPI;
+    data->snipe_cpi = CONFIG_PMW3610_SNIPE_CPI;
+    data->force_awake = IS_ENABLED(CONFIG_PMW3610_FORCE_AWAKE);
+    data->run_downshift_ms = CONFIG_PMW3610_RUN_DOWNSHIFT_TIME_MS;
+    data->rest1_downshift_ms = CONFIG_PMW3610_REST1_DOWNSHIFT_TIME_MS;
+    data->rest2_downshift_ms = CONFIG_PMW3610_REST2_DOWNSHIFT_TIME_MS;
+    data->rest1_sample_ms = CONFIG_PMW3610_REST1_SAMPLE_TIME_MS;
+    data->rest2_sample_ms =
+        CONFIG_PMW3610_REST2_SAMPLE_TIME_MS >= 10 ? CONFIG_PMW3610_REST2_SAMPLE_TIME_MS : 0;
+    data->rest3_sample_ms =
+        CONFIG_PMW3610_REST3_SAMPLE_TIME_MS >= 10 ? CONFIG_PMW3610_REST3_SAMPLE_TIME_MS : 0;
+
+    // init the shadow of the configuration registers
+    shadow_init(data);
+#if CONFIG_PMW3610_REG_CHECK_INTERVAL_MS > 0
+    k_work_init_delayable(&data->reg_check_work, pmw3610_reg_check_work_callback);
+#endif
+
+    // init automouse layer timer
+    k_timer_init(&data->automouse_layer_timer, deactivate_automouse_layer, NULL);
+
+    // init the input mode of each layer
+    build_layer_modes(dev);
+    update_layer_mode(dev);
+
 #ifdef CONFIG_PMW3610_SCROLL_SNAP
     // init scroll snap data
     data->scroll_snap_accumulated_x = 0;
     data->scroll_snap_accumulated_y = 0;
-    data->scroll_snap_last_time = 0;
-    data->scroll_snap_deadtime_start = 0;
+    data->scroll_snap_last_valid = false;
     data->scroll_snap_in_deadtime = false;
 #endif
     
     // init trigger handler work
     k_work_init(&data->trigger_work, pmw3610_work_callback);
 
+    // init pointer report flush work
+    k_work_init_delayable(&data->flush_work, pmw3610_flush_work_callback);
+
+    // init the work applying the runtime settings and the layer triggered cpi switches
+    k_work_init_delayable(&data->config_work, pmw3610_config_work_callback);
+
+#ifdef CONFIG_PMW3610_DEDICATED_WORKQUEUE
+    pmw3610_work_q_start();
+#endif
+
     // check readiness of cs gpio pin and init it to inactive
     if (!device_is_ready(config->cs_gpio.port)) {
         LOG_ERR("SPI CS device not ready");
@@ -1102,11 +2372,202 @@ static int pmw3610_init(const struct device *dev) {
     // The sensor is ready to work (i.e., data->ready=true after the above steps are finished)
     k_work_init_delayable(&data->init_work, pmw3610_async_init);
 
+#ifdef CONFIG_PMW3610_SUSPEND_ON_IDLE
+    k_work_init_delayable(&data->idle_work, pmw3610_idle_work_callback);
+#endif
+
+#ifdef CONFIG_PM_DEVICE_RUNTIME
+    // the init sequence starts on the first resume, which takes the bus. The driver keeps the
+    // sensor active with its own reference, released while idle with SUSPEND_ON_IDLE.
+    data->suspended = true;
+    pm_device_init_suspended(dev);
+    err = pm_device_runtime_enable(dev);
+    if (!err) {
+        err = pm_device_runtime_get(dev);
+    }
+#else
+    data->init_step_start = k_uptime_get();
     k_work_schedule(&data->init_work, K_MSEC(async_init_delay[data->async_init_step]));
+#endif
 
     return err;
 }
 
+//////// Sensor attributes //////////
+// Runtime tuning of the sensor, see enum pmw3610_attribute. The settings are validated and     //
+// stored here, and written by the config work on the motion work queue: the caller may be the //
+// system work queue, which must not wait for the bus. A suspended or not yet initialized     //
+// sensor gets them once ready.                                                                //
+static int pmw3610_attr_set_cpi(const struct device *dev, uint32_t *cpi, uint32_t value) {
+    struct pixart_data *data = dev->data;
+
+    if ((value > PMW3610_MAX_CPI) || (value < PMW3610_MIN_CPI) || (value % PMW3610_CPI_STEP)) {
+        LOG_WRN("CPI value %u out of range or not a multiple of %u", value, PMW3610_CPI_STEP);
+        return -EINVAL;
+    }
+
+    *cpi = value;
+    pmw3610_schedule_work(&data->config_work, K_NO_WAIT);
+    return 0;
+}
+
+static int pmw3610_attr_set_time(const struct device *dev, uint32_t attr, uint32_t time) {
+    struct pixart_data *data = dev->data;
+    uint32_t *setting;
+    uint8_t value;
+    int err;
+
+    // a sample time is the unit of the downshift time of its mode, which must stay in range
+    switch (attr) {
+    case PMW3610_ATTR_RUN_DOWNSHIFT_TIME:
+        setting = &data->run_downshift_ms;
+        err = downshift_time_value(PMW3610_REG_RUN_DOWNSHIFT, time, 0, &value);
+        break;
+
+    case PMW3610_ATTR_REST1_DOWNSHIFT_TIME:
+        setting = &data->rest1_downshift_ms;
+        err = downshift_time_value(PMW3610_REG_REST1_DOWNSHIFT, time, data->rest1_sample_ms,
+                                   &value);
+        break;
+
+    case PMW3610_ATTR_REST2_DOWNSHIFT_TIME:
+        setting = &data->rest2_downshift_ms;
+        err = downshift_time_value(PMW3610_REG_REST2_DOWNSHIFT, time, data->rest2_sample_ms,
+                                   &value);
+        break;
+
+    case PMW3610_ATTR_REST1_SAMPLE_TIME:
+        setting = &data->rest1_sample_ms;
+        err = sample_time_value(time, &value);
+        if (!err) {
+            err = downshift_time_value(PMW3610_REG_REST1_DOWNSHIFT, data->rest1_downshift_ms,
+                                       time, &value);
+        }
+        break;
+
+    case PMW3610_ATTR_REST2_SAMPLE_TIME:
+        setting = &data->rest2_sample_ms;
+        err = sample_time_value(time, &value);
+        if (!err && data->rest2_downshift_ms != 0) {
+            err = downshift_time_value(PMW3610_REG_REST2_DOWNSHIFT, data->rest2_downshift_ms,
+                                       time, &value);
+        }
+        break;
+
+    case PMW3610_ATTR_REST3_SAMPLE_TIME:
+        setting = &data->rest3_sample_ms;
+        err = sample_time_value(time, &value);
+        break;
+
+    default:
+        return -ENOTSUP;
+    }
+
+    if (err) {
+        return err;
+    }
+
+    *setting = time;
+    atomic_set(&data->settings_changed, 1);
+    pmw3610_schedule_work(&data->config_work, K_NO_WAIT);
+    return 0;
+}
+
+static int pmw3610_attr_set(const struct device *dev, enum sensor_channel chan,
+                            enum sensor_attribute attr, const struct sensor_value *val) {
+    struct pixart_data *data = dev->data;
+
+    if (chan != SENSOR_CHAN_ALL) {
+        return -ENOTSUP;
+    }
+
+    switch ((uint32_t)attr) {
+    case PMW3610_ATTR_CPI:
+        return pmw3610_attr_set_cpi(dev, &data->cpi, PMW3610_SVALUE_TO_CPI(*val));
+
+    case PMW3610_ATTR_SNIPE_CPI:
+        return pmw3610_attr_set_cpi(dev, &data->snipe_cpi, PMW3610_SVALUE_TO_CPI(*val));
+
+    case PMW3610_ATTR_RUN_DOWNSHIFT_TIME:
+    case PMW3610_ATTR_REST1_DOWNSHIFT_TIME:
+    case PMW3610_ATTR_REST2_DOWNSHIFT_TIME:
+    case PMW3610_ATTR_REST1_SAMPLE_TIME:
+    case PMW3610_ATTR_REST2_SAMPLE_TIME:
+    case PMW3610_ATTR_REST3_SAMPLE_TIME:
+        return pmw3610_attr_set_time(dev, (uint32_t)attr, PMW3610_SVALUE_TO_TIME(*val));
+
+    case PMW3610_ATTR_FORCE_AWAKE:
+        data->force_awake = val->val1 != 0;
+        atomic_set(&data->settings_changed, 1);
+        pmw3610_schedule_work(&data->config_work, K_NO_WAIT);
+        return 0;
+
+    default:
+        LOG_ERR("Unknown attribute");
+        return -ENOTSUP;
+    }
+}
+
+static int pmw3610_attr_get(const struct device *dev, enum sensor_channel chan,
+                            enum sensor_attribute attr, struct sensor_value *val) {
+    struct pixart_data *data = dev->data;
+    uint32_t value;
+
+    if (chan != SENSOR_CHAN_ALL) {
+        return -ENOTSUP;
+    }
+
+    switch ((uint32_t)attr) {
+    case PMW3610_ATTR_CPI:
+        value = data->cpi;
+        break;
+
+    case PMW3610_ATTR_SNIPE_CPI:
+        value = data->snipe_cpi;
+        break;
+
+    case PMW3610_ATTR_RUN_DOWNSHIFT_TIME:
+        value = data->run_downshift_ms;
+        break;
+
+    case PMW3610_ATTR_REST1_DOWNSHIFT_TIME:
+        value = data->rest1_downshift_ms;
+        break;
+
+    case PMW3610_ATTR_REST2_DOWNSHIFT_TIME:
+        value = data->rest2_downshift_ms;
+        break;
+
+    case PMW3610_ATTR_REST1_SAMPLE_TIME:
+        value = data->rest1_sample_ms;
+        break;
+
+    case PMW3610_ATTR_REST2_SAMPLE_TIME:
+        value = data->rest2_sample_ms;
+        break;
+
+    case PMW3610_ATTR_REST3_SAMPLE_TIME:
+        value = data->rest3_sample_ms;
+        break;
+
+    case PMW3610_ATTR_FORCE_AWAKE:
+        value = data->force_awake;
+        break;
+
+    default:
+        LOG_ERR("Unknown attribute");
+        return -ENOTSUP;
+    }
+
+    val->val1 = value;
+    val->val2 = 0;
+    return 0;
+}
+
+static const struct sensor_driver_api pmw3610_driver_api = {
+    .attr_set = pmw3610_attr_set,
+    .attr_get = pmw3610_attr_get,
+};
 
 #define TRANSFORMED_BINDINGS(n)                                                                    \
     { LISTIFY(DT_PROP_LEN(n, bindings), ZMK_KEYMAP_EXTRACT_BINDING, (, ), n) }
@@ -1126,20 +2587,27 @@ static int pmw3610_init(const struct device *dev) {
     };
 
 
-DT_INST_FOREACH_CHILD(0, BALL_ACTIONS_INST)
-
 #define BALL_ACTIONS_ITEM(n) &ball_action_cfg_##n,
 #define BALL_ACTIONS_UTIL_ONE(n) 1 +
 
-#define BALL_ACTIONS_LEN (DT_INST_FOREACH_CHILD(0, BALL_ACTIONS_UTIL_ONE) 0)
+#define BALL_ACTIONS_LEN(n) (DT_INST_FOREACH_CHILD(n, BALL_ACTIONS_UTIL_ONE) 0)
 
 #define PMW3610_DEFINE(n)                                                                          \
+    DT_INST_FOREACH_CHILD(n, BALL_ACTIONS_INST)                                                    \
+                                                                                                   \
     static struct pixart_data data##n;                                                             \
     static int32_t scroll_layers##n[] = DT_PROP(DT_DRV_INST(n), scroll_layers);                    \
     static int32_t snipe_layers##n[] = DT_PROP(DT_DRV_INST(n), snipe_layers);                      \
-    static struct ball_action_cfg *ball_actions[] = {DT_INST_FOREACH_CHILD(0, BALL_ACTIONS_ITEM)}; \
+    static struct ball_action_cfg *ball_actions##n[] = {                                           \
+        DT_INST_FOREACH_CHILD(n, BALL_ACTIONS_ITEM)};                                              \
+    static const int32_t accel_curve##n[] = DT_INST_PROP(n, accel_curve);                          \
+    static const int32_t snipe_accel_curve##n[] = DT_INST_PROP(n, snipe_accel_curve);              \
+    BUILD_ASSERT(DT_INST_PROP_LEN(n, accel_curve) % 2 == 0,                                        \
+                 "accel-curve must hold (speed, multiplier) pairs");                               \
+    BUILD_ASSERT(DT_INST_PROP_LEN(n, snipe_accel_curve) % 2 == 0,                                  \
+                 "snipe-accel-curve must hold (speed, multiplier) pairs");                         \
     static const struct pixart_config config##n = {                                                \
-        .irq_gpio = GPIO_DT_SPEC_INST_GET(n, irq_gpios),                                           \
+        .irq_gpio = GPIO_DT_SPEC_INST_GET_OR(n, irq_gpios, {0}),                                   \
         .bus =                                                                                     \
             {                                                                                      \
                 .bus = DEVICE_DT_GET(DT_INST_BUS(n)),                                              \
@@ -1156,11 +2624,49 @@ DT_INST_FOREACH_CHILD(0, BALL_ACTIONS_INST)
         .scroll_layers_len = DT_PROP_LEN(DT_DRV_INST(n), scroll_layers),                           \
         .snipe_layers = snipe_layers##n,                                                           \
         .snipe_layers_len = DT_PROP_LEN(DT_DRV_INST(n), snipe_layers),                             \
-        .ball_actions = ball_actions,                                                              \
-        .ball_actions_len = BALL_ACTIONS_LEN,                                                      \
+        .ball_actions = ball_actions##n,                                                           \
+        .ball_actions_len = BALL_ACTIONS_LEN(n),                                                   \
+        .automouse_layer = DT_INST_PROP(n, automouse_layer),                                       \
+        .accel_curve = {accel_curve##n, DT_INST_PROP_LEN(n, accel_curve) / 2},                     \
+        .snipe_accel_curve = {snipe_accel_curve##n, DT_INST_PROP_LEN(n, snipe_accel_curve) / 2},   \
     };                                                                                             \
                                                                                                    \
-    DEVICE_DT_INST_DEFINE(n, pmw3610_init, NULL, &data##n, &config##n, POST_KERNEL,                \
-                          CONFIG_SENSOR_INIT_PRIORITY, NULL);
+    PM_DEVICE_DT_INST_DEFINE(n, pmw3610_pm_action);                                                \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, pmw3610_init, PM_DEVICE_DT_INST_GET(n), &data##n, &config##n,         \
+                          POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY, &pmw3610_driver_api);
 
 DT_INST_FOREACH_STATUS_OKAY(PMW3610_DEFINE)
+
+#define PMW3610_DEVICE_ITEM(n) DEVICE_DT_INST_GET(n),
+
+static const struct device *const pmw3610_devs[] = {DT_INST_FOREACH_STATUS_OKAY(PMW3610_DEVICE_ITEM)};
+
+static int pmw3610_layer_state_listener(const zmk_event_t *eh) {
+    for (size_t i = 0; i < ARRAY_SIZE(pmw3610_devs); i++) {
+        update_layer_mode(pmw3610_devs[i]);
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(pmw3610, pmw3610_layer_state_listener);
+ZMK_SUBSCRIPTION(pmw3610, zmk_layer_state_changed);
+
+#ifdef CONFIG_PMW3610_SUSPEND_ON_IDLE
+static int pmw3610_activity_state_listener(const zmk_event_t *eh) {
+    const struct zmk_activity_state_changed *ev = as_zmk_activity_state_changed(eh);
+
+    for (size_t i = 0; i < ARRAY_SIZE(pmw3610_devs); i++) {
+        struct pixart_data *data = pmw3610_devs[i]->data;
+
+        data->idle_requested = ev->state != ZMK_ACTIVITY_ACTIVE;
+        pmw3610_schedule_work(&data->idle_work, K_NO_WAIT);
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(pmw3610_activity, pmw3610_activity_state_listener);
+ZMK_SUBSCRIPTION(pmw3610_activity, zmk_activity_state_changed);
+#endif
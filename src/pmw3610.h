@@ -11,6 +11,8 @@ extern "C" {
  * k_busy_wait is used instead of k_sleep */
 // - sub-us time is rounded to us, due to the limitation of k_busy_wait, see :
 // https://github.com/zephyrproject-rtos/zephyr/issues/6498
+// - the gaps between transactions (T_SRX, T_SWX, T_BEXIT) are only waited for at the start of the
+//   next transaction, and only for the part which has not already elapsed
 #define T_NCS_SCLK 1     /* 120 ns (rounded to 1us) */
 #define T_SCLK_NCS_WR 10 /* 10 us */
 #define T_SRAD 4         /* 4 us */
@@ -19,6 +21,16 @@ extern "C" {
 #define T_SWX 30         /* SWW: 30 us, SWR: 20 us */
 #define T_BEXIT 1        /* 250 ns (rounded to 1us)*/
 
+/* Time (in ms) given to the sensor to leave shutdown, before it is configured again */
+#define T_WAKEUP_MS 2
+
+/* Delay (in us) before a work item retries to take the bus from an asynchronous motion burst */
+#define T_BUS_RETRY_US 200
+
+/* Bounds (in ms) of the backoff between attempts to write the runtime settings */
+#define PMW3610_CONFIG_RETRY_MIN_MS 10
+#define PMW3610_CONFIG_RETRY_MAX_MS 1000
+
 /* Sensor registers (addresses) */
 #define PMW3610_REG_PRODUCT_ID 0x00
 #define PMW3610_REG_REVISION_ID 0x01
@@ -49,6 +61,7 @@ extern "C" {
 #define PMW3610_REG_REST2_DOWNSHIFT 0x1F
 #define PMW3610_REG_REST3_PERIOD 0x20
 #define PMW3610_REG_OBSERVATION 0x2D
+#define PMW3610_REG_SMART_MODE 0x32 /* not documented, toggled by the smart algorithm */
 
 #define PMW3610_REG_PIXEL_GRAB 0x35
 #define PMW3610_REG_FRAME_GRAB 0x36
@@ -75,10 +88,23 @@ extern "C" {
 #define PMW3610_POWERUP_CMD_RESET 0x5A
 #define PMW3610_POWERUP_CMD_WAKEUP 0x96
 
+/* Shutdown register command */
+#define PMW3610_SHUTDOWN_CMD 0xE7
+
 /* spi clock enable/disable commands */
 #define PMW3610_SPI_CLOCK_CMD_ENABLE 0xBA
 #define PMW3610_SPI_CLOCK_CMD_DISABLE 0xB5
 
+/* spi page select commands, written to PMW3610_REG_SPI_PAGE0 (or its page 1 alias) */
+#define PMW3610_SPI_PAGE_CMD_PAGE0 0x00
+#define PMW3610_SPI_PAGE_CMD_PAGE1 0xFF
+
+/* Page 1 registers are addressed with bit 7 set, e.g. PMW3610_REG_RES_STEP */
+#define PMW3610_PAGE1_BIT BIT(7)
+
+/* Max register writes queued in a single write session */
+#define PMW3610_SESSION_MAX_WRITES 16
+
 /* Max register count readable in a single motion burst */
 #define PMW3610_MAX_BURST_SIZE 10
 
@@ -86,19 +112,40 @@ extern "C" {
 #define PMW3610_BURST_SIZE 7
 
 /* Position in the motion registers */
+#define PMW3610_MOTION_POS 0
 #define PMW3610_X_L_POS 1
 #define PMW3610_Y_L_POS 2
 #define PMW3610_XY_H_POS 3
 #define PMW3610_SHUTTER_H_POS 5
 #define PMW3610_SHUTTER_L_POS 6
 
+/* Motion register bits */
+#define PMW3610_MOTION_MOT BIT(7) /* motion occurred since the last read */
+
 /* cpi/resolution range */
 #define PMW3610_MAX_CPI 3200
 #define PMW3610_MIN_CPI 200
+#define PMW3610_CPI_STEP 200
 
 /* write command bit position */
 #define SPI_WRITE_BIT BIT(7)
 
+/* Sensor attributes, set and read with sensor_attr_set()/sensor_attr_get() on SENSOR_CHAN_ALL.
+ * CPIs are in counts per inch and times in ms, both as val1. A new value is written to the sensor
+ * by the motion work queue shortly after the set; the REST2/REST3 times read 0 while left at the
+ * sensor default. */
+enum pmw3610_attribute {
+    PMW3610_ATTR_CPI = SENSOR_ATTR_PRIV_START, // cpi of every mode but SNIPE
+    PMW3610_ATTR_SNIPE_CPI,
+    PMW3610_ATTR_RUN_DOWNSHIFT_TIME,
+    PMW3610_ATTR_REST1_DOWNSHIFT_TIME,
+    PMW3610_ATTR_REST2_DOWNSHIFT_TIME,
+    PMW3610_ATTR_REST1_SAMPLE_TIME,
+    PMW3610_ATTR_REST2_SAMPLE_TIME,
+    PMW3610_ATTR_REST3_SAMPLE_TIME,
+    PMW3610_ATTR_FORCE_AWAKE, // val1 is 1 to keep the sensor in the RUN state, 0 otherwise
+};
+
 /* Helper macros used to convert sensor values. */
 #define PMW3610_SVALUE_TO_CPI(svalue) ((uint32_t)(svalue).val1)
 #define PMW3610_SVALUE_TO_TIME(svalue) ((uint32_t)(svalue).val1)
@@ -111,13 +158,11 @@ extern "C" {
 #error "A valid PMW3610 polling rate must be selected"
 #endif
 
-#ifdef CONFIG_PMW3610_FORCE_AWAKE
-#define PMW3610_FORCE_MODE_VALUE 0xF0
-#else
-#define PMW3610_FORCE_MODE_VALUE 0x00
-#endif
+/* Performance register bits keeping the sensor in the RUN state */
+#define PMW3610_FORCE_AWAKE_VALUE 0xF0
 
-#define PMW3610_PERFORMANCE_VALUE (PMW3610_FORCE_MODE_VALUE | PMW3610_POLLING_RATE_VALUE)
+#define PMW3610_PERFORMANCE_VALUE(force_awake)                                                     \
+    (((force_awake) ? PMW3610_FORCE_AWAKE_VALUE : 0x00) | PMW3610_POLLING_RATE_VALUE)
 
 #ifdef CONFIG_PMW3610_INVERT_SCROLL_X
 #define PMW3610_SCROLL_X_NEGATIVE 1
@@ -135,6 +180,38 @@ extern "C" {
 #define PMW3610_SCROLL_Y_POSITIVE 1
 #endif
 
+/* Scroll deltas are kept in 1/PMW3610_SCROLL_DELTA_SCALE counts, so that a tick of them is a
+ * high-resolution wheel unit */
+#ifdef CONFIG_PMW3610_SCROLL_REPORT_HIRES
+#define PMW3610_SCROLL_DELTA_SCALE CONFIG_PMW3610_SCROLL_HIRES_MULTIPLIER
+#else
+#define PMW3610_SCROLL_DELTA_SCALE 1
+#endif
+
+/* Timeouts of input reports. Without waiting, the motion of a rejected report is carried over */
+#ifdef CONFIG_PMW3610_REPORT_NO_WAIT
+#define PMW3610_POINTER_REPORT_TIMEOUT K_NO_WAIT
+#define PMW3610_SCROLL_REPORT_TIMEOUT K_NO_WAIT
+#else
+#define PMW3610_POINTER_REPORT_TIMEOUT K_FOREVER
+#define PMW3610_SCROLL_REPORT_TIMEOUT K_MSEC(10)
+#endif
+
+#ifdef CONFIG_PMW3610_STATS
+#define PMW3610_STATS_INC(data, field) ((data)->stats.field++)
+#define PMW3610_STATS_ADD(data, field, val) ((data)->stats.field += (val))
+#else
+#define PMW3610_STATS_INC(data, field) ((void)(data))
+#define PMW3610_STATS_ADD(data, field, val) ((void)(data))
+#endif
+
+/* Register access for diagnostics, e.g. from the shell. Page 1 registers are addressed with
+ * PMW3610_PAGE1_BIT, writes to shadowed registers update the shadow. -EBUSY until the sensor is
+ * initialized, or while it is suspended. Writes to the page selection registers and to RES_STEP
+ * fail with -EPERM, the cpi is set through PMW3610_ATTR_CPI. */
+int pmw3610_reg_read(const struct device *dev, uint8_t reg, uint8_t *val);
+int pmw3610_reg_write(const struct device *dev, uint8_t reg, uint8_t val);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT pixart_pmw3610
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include "pmw3610.h"
+#include "pmw3610_emul.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(pmw3610_emul, CONFIG_INPUT_LOG_LEVEL);
+
+/* Time the observation self-test takes after the register is cleared */
+#define PMW3610_EMUL_SELF_TEST_MS 10
+
+/* Motion counts are reported as 12-bit two's complement values */
+#define PMW3610_EMUL_DELTA_MAX 2047
+#define PMW3610_EMUL_DELTA_MIN -2048
+
+struct pmw3610_emul_cfg {
+    struct gpio_dt_spec irq_gpio;
+};
+
+struct pmw3610_emul_data {
+    const struct emul *target;
+    struct k_spinlock lock;
+
+    // register file, one per page
+    uint8_t regs[2][128];
+    uint8_t page;
+    bool clk_on;
+    bool shutdown;
+    int64_t self_test_done; // uptime at which the observation bits are set again
+
+    // read command latched by the address phase of a read
+    int read_addr;
+
+    // motion accumulated since the last read
+    int32_t dx;
+    int32_t dy;
+    bool motion;
+    uint16_t shutter;
+    uint32_t irq_cyc;
+
+    // scripted motion
+    struct k_timer play_timer;
+    const struct pmw3610_emul_frame *frames;
+    size_t frames_len;
+    size_t frame_pos;
+    bool repeat;
+
+    struct pmw3610_emul_bus_stats stats;
+};
+
+static void emul_update_irq(const struct emul *target) {
+    const struct pmw3610_emul_cfg *cfg = target->cfg;
+    struct pmw3610_emul_data *data = target->data;
+
+    if (cfg->irq_gpio.port == NULL) {
+        return;
+    }
+
+    int active = data->motion && !data->shutdown;
+    int level = (cfg->irq_gpio.dt_flags & GPIO_ACTIVE_LOW) ? !active : active;
+
+    gpio_emul_input_set(cfg->irq_gpio.port, cfg->irq_gpio.pin, level);
+}
+
+static void emul_reset(struct pmw3610_emul_data *data) {
+    memset(data->regs, 0, sizeof(data->regs));
+
+    data->regs[0][PMW3610_REG_PRODUCT_ID] = PMW3610_PRODUCT_ID;
+    data->regs[0][PMW3610_REG_REVISION_ID] = 0x01;
+    data->regs[0][PMW3610_REG_NOT_PROD_ID] = (uint8_t)~PMW3610_PRODUCT_ID;
+    data->regs[0][PMW3610_REG_NOT_REV_ID] = (uint8_t)~0x01;
+    data->regs[0][PMW3610_REG_OBSERVATION] = 0x0F;
+    data->regs[1][PMW3610_REG_RES_STEP & ~PMW3610_PAGE1_BIT] = 800 / 200;
+
+    data->page = 0;
+    data->clk_on = false;
+    data->shutdown = false;
+    data->self_test_done = 0;
+    data->read_addr = -1;
+    data->dx = 0;
+    data->dy = 0;
+    data->motion = false;
+}
+
+static void emul_write(struct pmw3610_emul_data *data, uint8_t reg, uint8_t val) {
+    // the spi clock request register is the only one writable with the clock off
+    if (reg == PMW3610_REG_SPI_CLK_ON_REQ) {
+        if (val == PMW3610_SPI_CLOCK_CMD_ENABLE) {
+            data->clk_on = true;
+        } else if (val == PMW3610_SPI_CLOCK_CMD_DISABLE) {
+            data->clk_on = false;
+        }
+        return;
+    }
+
+    if (!data->clk_on) {
+        LOG_WRN("Write 0x%02x to 0x%02x with spi clock off", val, reg);
+        data->stats.dropped_writes++;
+        return;
+    }
+
+    if (reg == (PMW3610_REG_SPI_PAGE0 & ~PMW3610_PAGE1_BIT)) {
+        data->page = (val == PMW3610_SPI_PAGE_CMD_PAGE1) ? 1 : 0;
+        return;
+    }
+
+    if (data->page == 0) {
+        switch (reg) {
+        case PMW3610_REG_POWER_UP_RESET:
+            if (val == PMW3610_POWERUP_CMD_RESET) {
+                emul_reset(data);
+            } else if (val == PMW3610_POWERUP_CMD_WAKEUP) {
+                data->shutdown = false;
+            }
+            return;
+
+        case PMW3610_REG_SHUTDOWN:
+            if (val == PMW3610_SHUTDOWN_CMD) {
+                data->shutdown = true;
+                data->motion = false;
+            }
+            return;
+
+        case PMW3610_REG_OBSERVATION:
+            // bits are set again by the sensor once the self-test ran
+            data->regs[0][reg] = val;
+            data->self_test_done = k_uptime_get() + PMW3610_EMUL_SELF_TEST_MS;
+            return;
+
+        default:
+            break;
+        }
+    }
+
+    data->regs[data->page][reg] = val;
+}
+
+static void emul_latch_motion(struct pmw3610_emul_data *data, uint8_t *motion) {
+    int32_t dx = CLAMP(data->dx, PMW3610_EMUL_DELTA_MIN, PMW3610_EMUL_DELTA_MAX);
+    int32_t dy = CLAMP(data->dy, PMW3610_EMUL_DELTA_MIN, PMW3610_EMUL_DELTA_MAX);
+
+    motion[PMW3610_MOTION_POS] = data->motion ? PMW3610_MOTION_MOT : 0;
+    motion[PMW3610_X_L_POS] = dx & 0xFF;
+    motion[PMW3610_Y_L_POS] = dy & 0xFF;
+    motion[PMW3610_XY_H_POS] = (((dx >> 8) & 0x0F) << 4) | ((dy >> 8) & 0x0F);
+
+    // what does not fit the 12-bit registers is reported by the next read
+    data->dx -= dx;
+    data->dy -= dy;
+    data->motion = data->dx != 0 || data->dy != 0;
+}
+
+static uint8_t emul_read(struct pmw3610_emul_data *data, uint8_t reg) {
+    if (data->page == 0) {
+        switch (reg) {
+        case PMW3610_REG_MOTION: {
+            uint8_t motion[PMW3610_BURST_SIZE];
+
+            // reading the motion register latches the delta registers
+            emul_latch_motion(data, motion);
+            data->regs[0][PMW3610_REG_DELTA_X_L] = motion[PMW3610_X_L_POS];
+            data->regs[0][PMW3610_REG_DELTA_Y_L] = motion[PMW3610_Y_L_POS];
+            data->regs[0][PMW3610_REG_DELTA_XY_H] = motion[PMW3610_XY_H_POS];
+            data->regs[0][PMW3610_REG_SHUTTER_HIGHER] = (data->shutter >> 8) & 0x01;
+            data->regs[0][PMW3610_REG_SHUTTER_LOWER] = data->shutter & 0xFF;
+
+            if (motion[PMW3610_MOTION_POS] & PMW3610_MOTION_MOT) {
+                data->stats.motion_reads++;
+                data->stats.burst_irq_cyc = data->irq_cyc;
+            }
+            return motion[PMW3610_MOTION_POS];
+        }
+
+        case PMW3610_REG_OBSERVATION:
+            if (k_uptime_get() >= data->self_test_done) {
+                data->regs[0][reg] |= 0x0F;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return data->regs[data->page][reg];
+}
+
+static void emul_read_burst(struct pmw3610_emul_data *data, uint8_t *buf, size_t len) {
+    uint8_t burst[PMW3610_MAX_BURST_SIZE] = {0};
+
+    emul_latch_motion(data, burst);
+    burst[PMW3610_SHUTTER_H_POS] = (data->shutter >> 8) & 0x01;
+    burst[PMW3610_SHUTTER_L_POS] = data->shutter & 0xFF;
+
+    memcpy(buf, burst, MIN(len, sizeof(burst)));
+
+    data->stats.bursts++;
+    data->stats.burst_irq_cyc = data->irq_cyc;
+}
+
+static int pmw3610_emul_io(const struct emul *target, const struct spi_config *config,
+                           const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs) {
+    struct pmw3610_emul_data *data = target->data;
+
+    ARG_UNUSED(config);
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    data->stats.xfers++;
+
+    // the driver frames every command with its own transfers: the address (or address and value
+    // of a write) is sent first, the value of a read is clocked in by the next transfer
+    for (size_t i = 0; tx_bufs && i < tx_bufs->count; i++) {
+        const struct spi_buf *buf = &tx_bufs->buffers[i];
+        const uint8_t *bytes = buf->buf;
+
+        data->stats.bytes += buf->len;
+        if (bytes == NULL || buf->len == 0) {
+            continue;
+        }
+
+        if (bytes[0] & SPI_WRITE_BIT) {
+            if (buf->len >= 2) {
+                emul_write(data, bytes[0] & ~SPI_WRITE_BIT, bytes[1]);
+            }
+        } else {
+            data->read_addr = bytes[0];
+        }
+    }
+
+    for (size_t i = 0; rx_bufs && i < rx_bufs->count; i++) {
+        const struct spi_buf *buf = &rx_bufs->buffers[i];
+        uint8_t *bytes = buf->buf;
+
+        data->stats.bytes += buf->len;
+        if (bytes == NULL || buf->len == 0) {
+            continue;
+        }
+
+        if (data->read_addr == PMW3610_REG_MOTION_BURST) {
+            emul_read_burst(data, bytes, buf->len);
+        } else if (data->read_addr >= 0) {
+            memset(bytes, 0, buf->len);
+            bytes[0] = emul_read(data, data->read_addr);
+        } else {
+            memset(bytes, 0xFF, buf->len);
+        }
+        data->read_addr = -1;
+    }
+
+    emul_update_irq(target);
+
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+int pmw3610_emul_add_motion(const struct emul *target, int16_t dx, int16_t dy) {
+    struct pmw3610_emul_data *data = target->data;
+
+    if (dx == 0 && dy == 0) {
+        return 0;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    if (data->shutdown) {
+        k_spin_unlock(&data->lock, key);
+        return -EAGAIN;
+    }
+
+    if (!data->motion) {
+        data->irq_cyc = k_cycle_get_32();
+    }
+    data->dx += dx;
+    data->dy += dy;
+    data->motion = true;
+    emul_update_irq(target);
+
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+void pmw3610_emul_set_shutter(const struct emul *target, uint16_t shutter) {
+    struct pmw3610_emul_data *data = target->data;
+
+    data->shutter = shutter;
+}
+
+static void emul_play_timer_fn(struct k_timer *timer) {
+    struct pmw3610_emul_data *data = CONTAINER_OF(timer, struct pmw3610_emul_data, play_timer);
+    const struct pmw3610_emul_frame *frame = &data->frames[data->frame_pos];
+
+    if (++data->frame_pos >= data->frames_len) {
+        data->frame_pos = 0;
+        if (!data->repeat) {
+            k_timer_stop(timer);
+        }
+    }
+
+    pmw3610_emul_add_motion(data->target, frame->dx, frame->dy);
+}
+
+int pmw3610_emul_play(const struct emul *target, const struct pmw3610_emul_frame *frames,
+                      size_t count, uint32_t period_us, bool repeat) {
+    struct pmw3610_emul_data *data = target->data;
+
+    if (frames == NULL || count == 0 || period_us == 0) {
+        return -EINVAL;
+    }
+
+    k_timer_stop(&data->play_timer);
+
+    data->frames = frames;
+    data->frames_len = count;
+    data->frame_pos = 0;
+    data->repeat = repeat;
+
+    k_timer_start(&data->play_timer, K_USEC(period_us), K_USEC(period_us));
+
+    return 0;
+}
+
+void pmw3610_emul_stop(const struct emul *target) {
+    struct pmw3610_emul_data *data = target->data;
+
+    k_timer_stop(&data->play_timer);
+}
+
+bool pmw3610_emul_is_playing(const struct emul *target) {
+    struct pmw3610_emul_data *data = target->data;
+
+    return k_timer_remaining_ticks(&data->play_timer) > 0;
+}
+
+uint8_t pmw3610_emul_get_reg(const struct emul *target, uint8_t reg) {
+    struct pmw3610_emul_data *data = target->data;
+
+    return data->regs[(reg & PMW3610_PAGE1_BIT) ? 1 : 0][reg & ~PMW3610_PAGE1_BIT];
+}
+
+void pmw3610_emul_get_bus_stats(const struct emul *target, struct pmw3610_emul_bus_stats *stats) {
+    struct pmw3610_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    *stats = data->stats;
+    k_spin_unlock(&data->lock, key);
+}
+
+void pmw3610_emul_reset_bus_stats(const struct emul *target) {
+    struct pmw3610_emul_data *data = target->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    memset(&data->stats, 0, sizeof(data->stats));
+    k_spin_unlock(&data->lock, key);
+}
+
+static const struct spi_emul_api pmw3610_emul_api = {
+    .io = pmw3610_emul_io,
+};
+
+static int pmw3610_emul_init(const struct emul *target, const struct device *parent) {
+    struct pmw3610_emul_data *data = target->data;
+
+    ARG_UNUSED(parent);
+
+    data->target = target;
+    data->shutter = 0x40;
+    emul_reset(data);
+    k_timer_init(&data->play_timer, emul_play_timer_fn, NULL);
+
+    emul_update_irq(target);
+
+    return 0;
+}
+
+#define PMW3610_EMUL_DEFINE(n)                                                                     \
+    static struct pmw3610_emul_data pmw3610_emul_data_##n;                                         \
+    static const struct pmw3610_emul_cfg pmw3610_emul_cfg_##n = {                                  \
+        .irq_gpio = GPIO_DT_SPEC_INST_GET_OR(n, irq_gpios, {0}),                                   \
+    };                                                                                             \
+    EMUL_DT_INST_DEFINE(n, pmw3610_emul_init, &pmw3610_emul_data_##n, &pmw3610_emul_cfg_##n,       \
+                        &pmw3610_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(PMW3610_EMUL_DEFINE)
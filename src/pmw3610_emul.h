@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * @file pmw3610_emul.h
+ *
+ * @brief Emulator of the PMW3610 sensor, on a Zephyr SPI emulator bus
+ */
+
+#include <zephyr/drivers/emul.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* one frame of scripted motion, in sensor counts */
+struct pmw3610_emul_frame {
+    int16_t dx;
+    int16_t dy;
+};
+
+/* bus activity seen by the emulator */
+struct pmw3610_emul_bus_stats {
+    uint32_t xfers;          // spi transfers (each CS-framed transaction has two or more)
+    uint32_t bytes;          // bytes clocked in either direction
+    uint32_t dropped_writes; // writes ignored because the sensor spi clock was off
+    uint32_t bursts;         // motion bursts read
+    uint32_t motion_reads;   // motion register reads returning motion, when polled without burst
+    uint32_t burst_irq_cyc;  // cycle count at which the motion of the last read raised the irq
+};
+
+/** Add motion to the sensor accumulators and assert the motion irq */
+int pmw3610_emul_add_motion(const struct emul *target, int16_t dx, int16_t dy);
+
+/** Set the shutter value reported by motion bursts, used by the smart algorithm */
+void pmw3610_emul_set_shutter(const struct emul *target, uint16_t shutter);
+
+/** Feed scripted frames at a fixed period, optionally repeating the script */
+int pmw3610_emul_play(const struct emul *target, const struct pmw3610_emul_frame *frames,
+                      size_t count, uint32_t period_us, bool repeat);
+
+/** Stop the scripted motion */
+void pmw3610_emul_stop(const struct emul *target);
+
+/** Whether the scripted motion is still playing */
+bool pmw3610_emul_is_playing(const struct emul *target);
+
+/** Read an emulated register, page 1 registers are addressed with bit 7 set */
+uint8_t pmw3610_emul_get_reg(const struct emul *target, uint8_t reg);
+
+void pmw3610_emul_get_bus_stats(const struct emul *target, struct pmw3610_emul_bus_stats *stats);
+void pmw3610_emul_reset_bus_stats(const struct emul *target);
+
+#ifdef __cplusplus
+}
+#endif
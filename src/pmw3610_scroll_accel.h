@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+/*
+ * Fixed-point scroll acceleration, on the table generated by scripts/gen_scroll_accel_lut.py.
+ * Plain C without Zephyr dependencies, so that tests/scroll_accel checks it on the host.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <pmw3610_scroll_accel_lut.h>
+
+#define PMW3610_SCROLL_ACCEL_LUT_LEN                                                               \
+    (sizeof(pmw3610_scroll_accel_lut) / sizeof(pmw3610_scroll_accel_lut[0]))
+
+// Multiplier for a speed in counts/ms (Q PMW3610_SCROLL_ACCEL_SPEED_SHIFT), in Q
+// PMW3610_SCROLL_ACCEL_SHIFT. The table is interpolated linearly and flat past its end.
+static inline uint32_t pmw3610_scroll_accel_multiplier(uint32_t speed) {
+    uint32_t idx = speed >> PMW3610_SCROLL_ACCEL_STEP_SHIFT;
+
+    if (idx >= PMW3610_SCROLL_ACCEL_LUT_LEN - 1) {
+        return pmw3610_scroll_accel_lut[PMW3610_SCROLL_ACCEL_LUT_LEN - 1];
+    }
+
+    uint32_t frac = speed & ((1U << PMW3610_SCROLL_ACCEL_STEP_SHIFT) - 1);
+    uint32_t lo = pmw3610_scroll_accel_lut[idx];
+    uint32_t hi = pmw3610_scroll_accel_lut[idx + 1];
+
+    // the curve is increasing, so hi >= lo
+    return lo + (((hi - lo) * frac) >> PMW3610_SCROLL_ACCEL_STEP_SHIFT);
+}
+
+// Accelerated value of an axis, for a frame of movement counts (both axes) delta_us after the
+// previous scroll frame. Values of one count or less are left as they are.
+static inline int32_t pmw3610_scroll_accel(int16_t value, uint32_t movement, uint32_t delta_us) {
+    if (abs(value) <= 1) {
+        return value;
+    }
+
+    // counts/ms over the interval between the two frames
+    uint64_t speed = ((uint64_t)movement << PMW3610_SCROLL_ACCEL_SPEED_SHIFT) * 1000 / delta_us;
+    int32_t mult = pmw3610_scroll_accel_multiplier(speed > UINT32_MAX ? UINT32_MAX : speed);
+
+    // signed division truncates toward zero, as the float to int conversion did
+    return (value * mult) / (1 << PMW3610_SCROLL_ACCEL_SHIFT);
+}
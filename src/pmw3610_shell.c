@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Shell commands to inspect and tune the sensor at runtime: register dump and access, cpi and
+ * downshift times, the driver statistics and the latency histograms.
+ */
+
+#define DT_DRV_COMPAT pixart_pmw3610
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/drivers/sensor.h>
+#include "pmw3610.h"
+
+#define PMW3610_SHELL_DEVICE_ITEM(n) DEVICE_DT_INST_GET(n),
+
+static const struct device *const shell_devs[] = {
+    DT_INST_FOREACH_STATUS_OKAY(PMW3610_SHELL_DEVICE_ITEM)};
+
+struct shell_reg {
+    const char *name;
+    uint8_t reg;
+};
+
+/* Registers read by the dump. The motion registers are left out since reading them clears the
+ * motion the driver has not read yet, and so are the write-only command registers. */
+static const struct shell_reg shell_dump_regs[] = {
+    {"PRODUCT_ID", PMW3610_REG_PRODUCT_ID},
+    {"REVISION_ID", PMW3610_REG_REVISION_ID},
+    {"SQUAL", PMW3610_REG_SQUAL},
+    {"SHUTTER_HIGHER", PMW3610_REG_SHUTTER_HIGHER},
+    {"SHUTTER_LOWER", PMW3610_REG_SHUTTER_LOWER},
+    {"PIX_MAX", PMW3610_REG_PIX_MAX},
+    {"PIX_AVG", PMW3610_REG_PIX_AVG},
+    {"PIX_MIN", PMW3610_REG_PIX_MIN},
+    {"CRC0", PMW3610_REG_CRC0},
+    {"CRC1", PMW3610_REG_CRC1},
+    {"CRC2", PMW3610_REG_CRC2},
+    {"CRC3", PMW3610_REG_CRC3},
+    {"PERFORMANCE", PMW3610_REG_PERFORMANCE},
+    {"RUN_DOWNSHIFT", PMW3610_REG_RUN_DOWNSHIFT},
+    {"REST1_PERIOD", PMW3610_REG_REST1_PERIOD},
+    {"REST1_DOWNSHIFT", PMW3610_REG_REST1_DOWNSHIFT},
+    {"REST2_PERIOD", PMW3610_REG_REST2_PERIOD},
+    {"REST2_DOWNSHIFT", PMW3610_REG_REST2_DOWNSHIFT},
+    {"REST3_PERIOD", PMW3610_REG_REST3_PERIOD},
+    {"OBSERVATION", PMW3610_REG_OBSERVATION},
+    {"SMART_MODE", PMW3610_REG_SMART_MODE},
+    {"NOT_REV_ID", PMW3610_REG_NOT_REV_ID},
+    {"NOT_PROD_ID", PMW3610_REG_NOT_PROD_ID},
+    {"PRBS_TEST_CTL", PMW3610_REG_PRBS_TEST_CTL},
+    {"RES_STEP", PMW3610_REG_RES_STEP},
+    {"VCSEL_CTL", PMW3610_REG_VCSEL_CTL},
+    {"LSR_CONTROL", PMW3610_REG_LSR_CONTROL},
+};
+
+/* Downshift times, by the name of the mode they leave */
+static const struct {
+    const char *name;
+    enum pmw3610_attribute attr;
+} shell_downshifts[] = {
+    {"run", PMW3610_ATTR_RUN_DOWNSHIFT_TIME},
+    {"rest1", PMW3610_ATTR_REST1_DOWNSHIFT_TIME},
+    {"rest2", PMW3610_ATTR_REST2_DOWNSHIFT_TIME},
+};
+
+/* The sensor instance named by the first argument */
+static const struct device *shell_get_dev(const struct shell *sh, const char *name) {
+    for (size_t i = 0; i < ARRAY_SIZE(shell_devs); i++) {
+        if (strcmp(shell_devs[i]->name, name) == 0) {
+            return shell_devs[i];
+        }
+    }
+
+    shell_error(sh, "%s is not a pmw3610 sensor", name);
+    return NULL;
+}
+
+static int shell_parse_u8(const struct shell *sh, const char *arg, uint8_t *val) {
+    int err = 0;
+    unsigned long value = shell_strtoul(arg, 0, &err);
+
+    if (err || value > UINT8_MAX) {
+        shell_error(sh, "Invalid byte %s", arg);
+        return -EINVAL;
+    }
+
+    *val = value;
+    return 0;
+}
+
+static int cmd_dump(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(shell_dump_regs); i++) {
+        uint8_t val;
+        int err = pmw3610_reg_read(dev, shell_dump_regs[i].reg, &val);
+        if (err) {
+            shell_error(sh, "Cannot read %s: %d", shell_dump_regs[i].name, err);
+            return err;
+        }
+
+        shell_print(sh, "0x%02x %-16s 0x%02x", shell_dump_regs[i].reg, shell_dump_regs[i].name,
+                    val);
+    }
+
+    return 0;
+}
+
+static int cmd_read(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    uint8_t reg, val;
+
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+    if (shell_parse_u8(sh, argv[2], &reg)) {
+        return -EINVAL;
+    }
+
+    int err = pmw3610_reg_read(dev, reg, &val);
+    if (err) {
+        shell_error(sh, "Cannot read 0x%02x: %d", reg, err);
+        return err;
+    }
+
+    shell_print(sh, "0x%02x: 0x%02x", reg, val);
+    return 0;
+}
+
+static int cmd_write(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    uint8_t reg, val;
+
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+    if (shell_parse_u8(sh, argv[2], &reg) || shell_parse_u8(sh, argv[3], &val)) {
+        return -EINVAL;
+    }
+
+    int err = pmw3610_reg_write(dev, reg, val);
+    if (err == -EPERM) {
+        shell_error(sh, "0x%02x is managed by the driver, see the cpi command", reg);
+        return err;
+    }
+    if (err) {
+        shell_error(sh, "Cannot write 0x%02x: %d", reg, err);
+        return err;
+    }
+
+    return 0;
+}
+
+/* Print an attribute, after setting it when a value is given */
+static int shell_attr(const struct shell *sh, const struct device *dev,
+                      enum pmw3610_attribute attr, const char *value, const char *unit) {
+    struct sensor_value val = {0};
+    int err = 0;
+
+    if (value != NULL) {
+        val.val1 = shell_strtol(value, 10, &err);
+        if (err) {
+            shell_error(sh, "Invalid value %s", value);
+            return -EINVAL;
+        }
+
+        err = sensor_attr_set(dev, SENSOR_CHAN_ALL, (enum sensor_attribute)attr, &val);
+        if (err) {
+            shell_error(sh, "Cannot set %s: %d", value, err);
+            return err;
+        }
+    }
+
+    err = sensor_attr_get(dev, SENSOR_CHAN_ALL, (enum sensor_attribute)attr, &val);
+    if (err) {
+        shell_error(sh, "Cannot read back: %d", err);
+        return err;
+    }
+
+    shell_print(sh, "%d %s", val.val1, unit);
+    return 0;
+}
+
+static int cmd_cpi(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+    return shell_attr(sh, dev, PMW3610_ATTR_CPI, argc > 2 ? argv[2] : NULL, "cpi");
+}
+
+static int cmd_downshift(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(shell_downshifts); i++) {
+        if (strcmp(shell_downshifts[i].name, argv[2]) == 0) {
+            return shell_attr(sh, dev, shell_downshifts[i].attr, argc > 3 ? argv[3] : NULL, "ms");
+        }
+    }
+
+    shell_error(sh, "Unknown mode %s, expecting run, rest1 or rest2", argv[2]);
+    return -EINVAL;
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+#ifdef CONFIG_PMW3610_STATS
+    struct pixart_data *data = dev->data;
+    const struct pixart_stats *stats = &data->stats;
+
+    if (argc > 2) {
+        if (strcmp(argv[2], "reset") != 0) {
+            shell_error(sh, "Unknown argument %s", argv[2]);
+            return -EINVAL;
+        }
+
+        memset(&data->stats, 0, sizeof(data->stats));
+        return 0;
+    }
+
+    shell_print(sh, "motion_irqs: %u", stats->motion_irqs);
+    shell_print(sh, "max_queue_delay_us: %u", stats->max_queue_delay_us);
+    shell_print(sh, "drained_bursts: %u", stats->drained_bursts);
+    shell_print(sh, "reports: %u", stats->reports);
+    shell_print(sh, "report_cycles: %llu", (unsigned long long)stats->report_cycles);
+    shell_print(sh, "busy_wait_us: %llu", (unsigned long long)stats->busy_wait_us);
+    shell_print(sh, "input_reports: %u", stats->input_reports);
+    shell_print(sh, "report_backpressure: %u", stats->report_backpressure);
+    shell_print(sh, "reg_restores: %u", stats->reg_restores);
+    shell_print(sh, "bursts: %u", stats->bursts);
+    shell_print(sh, "zero_delta_frames: %u", stats->zero_delta_frames);
+    shell_print(sh, "spi_err_reg_read: %u", stats->spi_err_reg_read);
+    shell_print(sh, "spi_err_reg_write: %u", stats->spi_err_reg_write);
+    shell_print(sh, "spi_err_burst_read: %u", stats->spi_err_burst_read);
+    shell_print(sh, "cpi_switches: %u", stats->cpi_switches);
+    shell_print(sh, "smart_toggles: %u", stats->smart_toggles);
+    shell_print(sh, "scroll_ticks: %u", stats->scroll_ticks);
+    shell_print(sh, "scroll_ticks_truncated: %u", stats->scroll_ticks_truncated);
+    shell_print(sh, "ball_actions: %u", stats->ball_actions);
+    return 0;
+#else
+    shell_error(sh, "Statistics are disabled, see CONFIG_PMW3610_STATS");
+    return -ENOTSUP;
+#endif
+}
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+static const char *const shell_latency_stages[] = {
+    [LATENCY_IRQ_TO_WORK] = "irq_to_work",
+    [LATENCY_WORK_TO_BURST] = "work_to_burst",
+    [LATENCY_BURST_TO_REPORT] = "burst_to_report",
+};
+#endif
+
+static int cmd_latency(const struct shell *sh, size_t argc, char **argv) {
+    const struct device *dev = shell_get_dev(sh, argv[1]);
+    if (dev == NULL) {
+        return -ENODEV;
+    }
+
+#ifdef CONFIG_PMW3610_LATENCY_HISTOGRAM
+    struct pixart_data *data = dev->data;
+
+    if (argc > 2) {
+        if (strcmp(argv[2], "reset") != 0) {
+            shell_error(sh, "Unknown argument %s", argv[2]);
+            return -EINVAL;
+        }
+
+        memset(data->latency.hist, 0, sizeof(data->latency.hist));
+        return 0;
+    }
+
+    for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        shell_print(sh, "%s:", shell_latency_stages[stage]);
+
+        for (size_t i = 0; i < PIXART_LATENCY_BUCKETS; i++) {
+            uint32_t count = data->latency.hist[stage][i];
+            uint32_t low = i > 0 ? BIT(i - 1) : 0;
+
+            if (count == 0) {
+                continue;
+            }
+
+            if (i == PIXART_LATENCY_BUCKETS - 1) {
+                shell_print(sh, "  >= %u us: %u", low, count);
+            } else {
+                shell_print(sh, "  %u-%u us: %u", low, (uint32_t)BIT(i) - 1, count);
+            }
+        }
+    }
+
+    return 0;
+#else
+    shell_error(sh, "Histograms are disabled, see CONFIG_PMW3610_LATENCY_HISTOGRAM");
+    return -ENOTSUP;
+#endif
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_pmw3610,
+    SHELL_CMD_ARG(dump, NULL, "Dump the registers: dump <device>", cmd_dump, 2, 0),
+    SHELL_CMD_ARG(read, NULL,
+                  "Read a register, 0x80 selecting page 1: read <device> <reg>", cmd_read, 3, 0),
+    SHELL_CMD_ARG(write, NULL,
+                  "Write a register, 0x80 selecting page 1: write <device> <reg> <value>",
+                  cmd_write, 4, 0),
+    SHELL_CMD_ARG(cpi, NULL, "Get or set the cpi: cpi <device> [cpi]", cmd_cpi, 2, 1),
+    SHELL_CMD_ARG(downshift, NULL,
+                  "Get or set a downshift time: downshift <device> <run|rest1|rest2> [ms]",
+                  cmd_downshift, 3, 1),
+    SHELL_CMD_ARG(stats, NULL, "Print or reset the statistics: stats <device> [reset]", cmd_stats,
+                  2, 1),
+    SHELL_CMD_ARG(latency, NULL,
+                  "Print or reset the latency histograms: latency <device> [reset]", cmd_latency,
+                  2, 1),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(pmw3610, &sub_pmw3610, "PMW3610 sensor commands", NULL);
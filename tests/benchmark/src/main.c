@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Benchmark of the motion path, run against the emulated sensor (e.g. on native_sim). Scripted
+ * motion is fed at several frame rates in every input mode configured on the first sensor
+ * instance, and the cost per frame is printed after each run.
+ */
+
+#define DT_DRV_COMPAT pixart_pmw3610
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/version.h>
+#include <zephyr/input/input.h>
+#include <zephyr/sys/printk.h>
+#include <zmk/keymap.h>
+#include "pmw3610.h"
+#include "pmw3610_emul.h"
+
+#define BENCH_NODE DT_DRV_INST(0)
+
+static const struct device *const bench_dev = DEVICE_DT_GET(BENCH_NODE);
+static const struct emul *const bench_emul = EMUL_DT_GET(BENCH_NODE);
+
+/* frame rates of the runs, in Hz */
+static const uint32_t bench_rates[] = {125, 250, CONFIG_PMW3610_BENCHMARK_STRESS_RATE};
+
+/* slow to fast motion, in both directions, so every mode sees small and large deltas */
+static const struct pmw3610_emul_frame bench_frames[] = {
+    {1, 0},    {2, 1},    {3, -1},  {5, 2},   {8, -3},   {12, 4},   {18, -6},  {25, 9},
+    {-25, -9}, {-18, 6},  {-12, -4}, {-8, 3}, {-5, -2},  {-3, 1},   {-2, -1},  {-1, 0},
+};
+
+static const char *const bench_mode_names[] = {
+    [MOVE] = "move",
+    [SCROLL] = "scroll",
+    [SNIPE] = "snipe",
+    [BALL_ACTION] = "ball_action",
+};
+
+static struct {
+    bool running;
+    uint32_t events;
+    size_t samples_len;
+    uint32_t samples[CONFIG_PMW3610_BENCHMARK_MAX_SAMPLES]; // irq to input sync latency in us
+} bench;
+
+static void bench_input_event(struct input_event *evt) {
+    if (!bench.running) {
+        return;
+    }
+
+    bench.events++;
+    if (!evt->sync || bench.samples_len >= ARRAY_SIZE(bench.samples)) {
+        return;
+    }
+
+    struct pmw3610_emul_bus_stats bus;
+    pmw3610_emul_get_bus_stats(bench_emul, &bus);
+
+    bench.samples[bench.samples_len++] = k_cyc_to_us_floor32(k_cycle_get_32() - bus.burst_irq_cyc);
+}
+
+#if ZEPHYR_VERSION_CODE >= ZEPHYR_VERSION(3, 7, 0)
+static void bench_input_cb(struct input_event *evt, void *user_data) {
+    ARG_UNUSED(user_data);
+    bench_input_event(evt);
+}
+
+INPUT_CALLBACK_DEFINE(bench_dev, bench_input_cb, NULL);
+#else
+INPUT_CALLBACK_DEFINE(bench_dev, bench_input_event);
+#endif
+
+/* Layer to activate for a mode, 0 when no layer is needed and -ENOENT when not configured */
+static int bench_mode_layer(enum pixart_input_mode mode) {
+    const struct pixart_config *config = bench_dev->config;
+
+    switch (mode) {
+    case MOVE:
+        return 0;
+    case SCROLL:
+        return config->scroll_layers_len > 0 ? config->scroll_layers[0] : -ENOENT;
+    case SNIPE:
+        return config->snipe_layers_len > 0 ? config->snipe_layers[0] : -ENOENT;
+    case BALL_ACTION:
+        return config->ball_actions_len > 0 ? config->ball_actions[0]->layers[0] : -ENOENT;
+    default:
+        return -ENOENT;
+    }
+}
+
+static void bench_sort(uint32_t *values, size_t len) {
+    for (size_t i = 1; i < len; i++) {
+        uint32_t value = values[i];
+        size_t j = i;
+
+        for (; j > 0 && values[j - 1] > value; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+}
+
+static uint32_t bench_percentile(const uint32_t *sorted, size_t len, uint32_t pct) {
+    if (len == 0) {
+        return 0;
+    }
+
+    return sorted[MIN(len - 1, (len * pct) / 100)];
+}
+
+/* print a value per frame with two decimals */
+static void bench_print_per_frame(const char *name, uint64_t total, uint32_t frames) {
+    uint64_t centi = frames ? (total * 100) / frames : 0;
+
+    printk(" %s=%u.%02u", name, (uint32_t)(centi / 100), (uint32_t)(centi % 100));
+}
+
+static void bench_run(enum pixart_input_mode mode, uint32_t rate) {
+    struct pixart_data *data = bench_dev->data;
+    struct pmw3610_emul_bus_stats bus;
+
+    memset(&data->stats, 0, sizeof(data->stats));
+    pmw3610_emul_reset_bus_stats(bench_emul);
+    bench.events = 0;
+    bench.samples_len = 0;
+    bench.running = true;
+
+    pmw3610_emul_play(bench_emul, bench_frames, ARRAY_SIZE(bench_frames), USEC_PER_SEC / rate,
+                      true);
+    k_msleep(CONFIG_PMW3610_BENCHMARK_DURATION_MS);
+    pmw3610_emul_stop(bench_emul);
+
+    // let the last frames drain
+    k_msleep(50);
+    bench.running = false;
+
+    pmw3610_emul_get_bus_stats(bench_emul, &bus);
+    // frames are read by bursts, or register by register when polled
+    uint32_t frames = bus.bursts + bus.motion_reads;
+
+    printk("pmw3610 bench: mode=%s rate=%uHz frames=%u", bench_mode_names[mode], rate, frames);
+    bench_print_per_frame("cycles/report", data->stats.report_cycles, data->stats.reports);
+    bench_print_per_frame("spi_bytes/frame", bus.bytes, frames);
+    bench_print_per_frame("busy_us/frame", data->stats.busy_wait_us, frames);
+    bench_print_per_frame("input_reports/frame", data->stats.input_reports, frames);
+    printk(" backpressure=%u", data->stats.report_backpressure);
+    printk("\n");
+
+    if (bench.samples_len > 0) {
+        bench_sort(bench.samples, bench.samples_len);
+        printk("pmw3610 bench: latency_us n=%zu p50=%u p90=%u p99=%u max=%u\n", bench.samples_len,
+               bench_percentile(bench.samples, bench.samples_len, 50),
+               bench_percentile(bench.samples, bench.samples_len, 90),
+               bench_percentile(bench.samples, bench.samples_len, 99),
+               bench.samples[bench.samples_len - 1]);
+    }
+}
+
+static void bench_main(void *p1, void *p2, void *p3) {
+    struct pixart_data *data = bench_dev->data;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    // wait for the async init of the driver
+    for (int i = 0; !data->ready; i++) {
+        if (i >= 200) {
+            printk("pmw3610 bench: sensor not ready, aborting\n");
+            return;
+        }
+        k_msleep(10);
+    }
+
+    for (enum pixart_input_mode mode = MOVE; mode <= BALL_ACTION; mode++) {
+        int layer = bench_mode_layer(mode);
+        if (layer < 0) {
+            printk("pmw3610 bench: mode=%s skipped, no layer configured\n",
+                   bench_mode_names[mode]);
+            continue;
+        }
+
+        if (layer > 0) {
+            zmk_keymap_layer_activate(layer);
+        }
+        // let a layer triggered cpi change settle
+        k_msleep(20);
+
+        for (size_t i = 0; i < ARRAY_SIZE(bench_rates); i++) {
+            bench_run(mode, bench_rates[i]);
+        }
+
+        if (layer > 0) {
+            zmk_keymap_layer_deactivate(layer);
+        }
+    }
+
+    printk("pmw3610 bench: done\n");
+}
+
+K_THREAD_DEFINE(pmw3610_bench, CONFIG_PMW3610_BENCHMARK_STACK_SIZE, bench_main, NULL, NULL, NULL,
+                K_PRIO_PREEMPT(CONFIG_NUM_PREEMPT_PRIORITIES - 1), 0, 0);
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks the driver's fixed-point scroll acceleration (table lookup, interpolation and scaling)
+ * against the float curve it replaces. Every accelerated value may differ by at most one count,
+ * over sub-ms and ms frame intervals up to the 100 ms the driver accelerates within.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "pmw3610_scroll_accel.h"
+
+#define MAX_DELTA_US (100 * 1000 - 1)
+#define MAX_MOVEMENT 512
+
+static double accel(double speed) {
+    return 1.0 + (TEST_SENSITIVITY - 1.0) * (1.0 / (1.0 + exp(-0.2 * (speed - 10.0))));
+}
+
+static int32_t float_accel(int16_t value, uint32_t movement, uint32_t delta_us) {
+    if (abs(value) <= 1) {
+        return value;
+    }
+
+    return (int32_t)(value * accel(movement * 1000.0 / delta_us));
+}
+
+static int failures;
+
+static void check_value(int16_t value, uint32_t movement, uint32_t delta_us, int *worst) {
+    int32_t fixed = pmw3610_scroll_accel(value, movement, delta_us);
+    int err = abs(fixed - float_accel(value, movement, delta_us));
+
+    if (err > 1 && failures++ < 10) {
+        fprintf(stderr, "value %d, movement %u, %u us: %d instead of %d\n", value, movement,
+                delta_us, fixed, float_accel(value, movement, delta_us));
+    }
+    if (err > *worst) {
+        *worst = err;
+    }
+}
+
+static void check_delta(uint32_t delta_us, int *worst) {
+    for (uint32_t movement = 0; movement < MAX_MOVEMENT; movement++) {
+        for (int16_t value = 2; value <= (int16_t)movement; value++) {
+            check_value(value, movement, delta_us, worst);
+            check_value(-value, movement, delta_us, worst);
+        }
+    }
+}
+
+/* The multiplier hits the table on its steps, never decreases, and stays flat past the end */
+static void check_multiplier(void) {
+    uint32_t prev = 0;
+    uint32_t end = (uint32_t)PMW3610_SCROLL_ACCEL_LUT_LEN << PMW3610_SCROLL_ACCEL_STEP_SHIFT;
+
+    for (uint32_t speed = 0; speed < end + 4096; speed++) {
+        uint32_t mult = pmw3610_scroll_accel_multiplier(speed);
+        uint32_t idx = speed >> PMW3610_SCROLL_ACCEL_STEP_SHIFT;
+
+        if (mult < prev ||
+            ((speed & ((1U << PMW3610_SCROLL_ACCEL_STEP_SHIFT) - 1)) == 0 &&
+             idx < PMW3610_SCROLL_ACCEL_LUT_LEN && mult != pmw3610_scroll_accel_lut[idx])) {
+            if (failures++ < 10) {
+                fprintf(stderr, "multiplier %u at speed %u\n", mult, speed);
+            }
+        }
+        prev = mult;
+    }
+
+    if (pmw3610_scroll_accel_multiplier(UINT32_MAX) !=
+        pmw3610_scroll_accel_lut[PMW3610_SCROLL_ACCEL_LUT_LEN - 1]) {
+        failures++;
+        fprintf(stderr, "multiplier not flat past the end of the table\n");
+    }
+}
+
+int main(void) {
+    int worst = 0;
+
+    check_multiplier();
+
+    for (uint32_t delta_us = 1; delta_us < 1000; delta_us += 7) {
+        check_delta(delta_us, &worst);
+    }
+    for (uint32_t ms = 1; ms < 100; ms++) {
+        check_delta(ms * 1000, &worst);
+        check_delta(ms * 1000 + 500, &worst);
+    }
+    check_delta(MAX_DELTA_US, &worst);
+
+    printf("sensitivity %d: max error %d count(s), %d failure(s)\n", TEST_SENSITIVITY, worst,
+           failures);
+    return failures ? 1 : 0;
+}